@@ -0,0 +1,142 @@
+/*
+ * Times the editor's painting without a display: the editor is attached to a
+ * processor playing a synthetic chord and ribbon sequence, updated like its refresh
+ * would, and painted into an offscreen image with the software renderer.
+ * Reports ms per frame for the whole editor and for each section.
+ *
+ * Build with -DHARMONYSCAPE_BUILD_BENCHMARKS=ON and run HarmonyScapeEditorBenchmark.
+ */
+
+#include "../Source/PluginProcessor.h"
+#include "../Source/PluginEditor.h"
+
+// A part of the editor, painted as it is when only that area needs repainting
+struct PaintRegion
+{
+    juce::String name;
+    juce::Rectangle<int> area;
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+};
+
+static juce::Rectangle<int> getBoundsOfChildren(juce::Component& parent, const juce::String& componentID)
+{
+    juce::Rectangle<int> area;
+    for (auto* child : parent.getChildren())
+        if (child->getComponentID() == componentID)
+            area = area.isEmpty() ? child->getBounds() : area.getUnion(child->getBounds());
+
+    return area;
+}
+
+static double millisecondsSince(juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int frameRate = 60;
+    constexpr int warmUpFrames = 30;
+    constexpr int numFrames = 600;
+
+    HarmonyScapeAudioProcessor processor;
+
+    // Ribbons on, so every kind of voice is on screen
+    for (auto* parameter : processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            if (withID->paramID == "enableRibbons")
+                withID->setValueNotifyingHost(1.0f);
+
+    processor.setPlayConfigDetails(0, 2, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editorOwner(processor.createEditorIfNeeded());
+    auto* editor = dynamic_cast<HarmonyScapeAudioProcessorEditor*>(editorOwner.get());
+    if (editor == nullptr)
+        return 1;
+
+    editor->setVisible(true);
+
+    std::vector<PaintRegion> regions {
+        { "whole editor", editor->getLocalBounds() },
+        { "keyboard", getBoundsOfChildren(*editor, "keyboard") },
+        { "ADSR", getBoundsOfChildren(*editor, "adsrVisualizer") },
+        { "spatial", getBoundsOfChildren(*editor, "spatialVisualizer") },
+        { "ribbon controls", getBoundsOfChildren(*editor, "ribbonControls") }
+    };
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    const int chords[][3] = { { 60, 64, 67 }, { 57, 60, 64 }, { 62, 65, 69 }, { 55, 59, 62 } };
+    int block = 0;
+
+    for (float scale : { 1.0f, 2.0f })
+    {
+        // A software image, so the times are the software renderer's as the comparisons assume
+        juce::Image canvas(juce::Image::ARGB, juce::roundToInt(editor->getWidth() * scale),
+                           juce::roundToInt(editor->getHeight() * scale), true, juce::SoftwareImageType());
+
+        for (auto& region : regions)
+            region.totalMs = region.worstMs = 0.0;
+
+        for (int frame = 0; frame < warmUpFrames + numFrames; ++frame)
+        {
+            // One frame's worth of audio; a new chord every half second keeps voices
+            // starting, releasing and moving
+            const int samplesPerFrame = static_cast<int>(sampleRate) / frameRate;
+            for (int rendered = 0; rendered < samplesPerFrame; rendered += blockSize, ++block)
+            {
+                midi.clear();
+                if (block % 94 == 0)
+                {
+                    const auto& previous = chords[(block / 94 + 3) % 4];
+                    const auto& next = chords[(block / 94) % 4];
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        midi.addEvent(juce::MidiMessage::noteOff(1, previous[i]), 0);
+                        midi.addEvent(juce::MidiMessage::noteOn(1, next[i], 0.8f), 1);
+                    }
+                }
+
+                processor.processBlock(buffer, midi);
+            }
+
+            // What a refresh of the showing editor does each frame
+            editor->updateFromProcessor();
+
+            for (auto& region : regions)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                {
+                    juce::Graphics g(canvas);
+                    g.addTransform(juce::AffineTransform::scale(scale));
+                    g.reduceClipRegion(region.area);
+                    editor->paintEntireComponent(g, false);
+                }
+                const double ms = millisecondsSince(start);
+
+                // The first frames fill the cached layers
+                if (frame >= warmUpFrames)
+                {
+                    region.totalMs += ms;
+                    region.worstMs = juce::jmax(region.worstMs, ms);
+                }
+            }
+        }
+
+        std::printf("%.0fx scale, %d frames\n", scale, numFrames);
+        std::printf("                   mean (ms)   worst (ms)\n");
+        for (const auto& region : regions)
+            std::printf("%-16s %10.3f   %10.3f\n", region.name.toRawUTF8(), region.totalMs / numFrames, region.worstMs);
+        std::printf("\n");
+    }
+
+    editorOwner.reset();
+    processor.releaseResources();
+    return 0;
+}
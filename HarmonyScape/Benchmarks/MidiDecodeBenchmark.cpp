@@ -0,0 +1,82 @@
+/*
+ * Times decoding a block of incoming MIDI into note events: NoteEventBuffer::addMidi
+ * reading the raw bytes once, against the two getMessage() passes it replaced
+ * (ChordEngine and SpatialEngine each building a juce::MidiMessage per event).
+ * The block is 512 controller messages with three notes among them, as from a
+ * controller sweeping a knob while a chord is played.
+ *
+ * Build with -DHARMONYSCAPE_BUILD_BENCHMARKS=ON and run HarmonyScapeMidiDecodeBenchmark.
+ */
+
+#include "../Source/NoteEvent.h"
+
+// One engine's pass over the block as it was before addMidi
+static void decodeWithMessages(const juce::MidiBuffer& midi, NoteEventBuffer& events)
+{
+    for (const auto metadata : midi)
+    {
+        const auto message = metadata.getMessage();
+        if (message.isNoteOn())
+            events.add(NoteEvent::noteOn(metadata.samplePosition, message.getChannel(), message.getNoteNumber(),
+                                         message.getFloatVelocity(), NoteEvent::Source::Input));
+        else if (message.isNoteOff())
+            events.add(NoteEvent::noteOff(metadata.samplePosition, message.getChannel(), message.getNoteNumber(),
+                                          NoteEvent::Source::Input));
+    }
+}
+
+static double microsecondsSince(juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+}
+
+int main()
+{
+    constexpr int blockSize = 512;
+    constexpr int numControllers = 512;
+    constexpr int warmUpBlocks = 1000;
+    constexpr int numBlocks = 20000;
+
+    juce::MidiBuffer midi;
+    for (int i = 0; i < numControllers; ++i)
+        midi.addEvent(juce::MidiMessage::controllerEvent(1, 1, i & 127), i * blockSize / numControllers);
+
+    for (int note : { 60, 64, 67 })
+        midi.addEvent(juce::MidiMessage::noteOn(1, note, 0.8f), note);
+
+    NoteEventBuffer events;
+    int numDecoded = 0;     // Read back so the loops can't be optimised away
+
+    const auto time = [&](auto&& decode)
+    {
+        double totalUs = 0.0;
+        double bestUs = std::numeric_limits<double>::max();
+
+        for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+        {
+            events.clear();
+            const auto start = juce::Time::getHighResolutionTicks();
+            decode();
+            const double us = microsecondsSince(start);
+            numDecoded += events.size();
+
+            if (block >= warmUpBlocks)
+            {
+                totalUs += us;
+                bestUs = juce::jmin(bestUs, us);
+            }
+        }
+
+        return std::make_pair(totalUs / numBlocks, bestUs);
+    };
+
+    const auto raw = time([&] { events.addMidi(midi, NoteEvent::Source::Input); });
+    const auto messages = time([&] { decodeWithMessages(midi, events); decodeWithMessages(midi, events); });
+
+    std::printf("%d controllers + 3 notes per block, %d blocks\n", numControllers, numBlocks);
+    std::printf("                          mean (us)   best (us)\n");
+    std::printf("addMidi                  %9.2f   %9.2f\n", raw.first, raw.second);
+    std::printf("two getMessage() passes  %9.2f   %9.2f\n", messages.first, messages.second);
+    std::printf("(%d events decoded)\n", numDecoded);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * Times a preset morph sweep at control rate against automating every morphed
+ * parameter on its own lane. Four presets with random settings fill the morph
+ * slots. Each block the morph path moves the Morph parameter and evaluates the
+ * morph into the parameter snapshot, as processBlock does; the automation path
+ * sets each differing parameter the way a host plays back automation, and then
+ * updates the snapshot. Reports us per block for each.
+ *
+ * Build with -DHARMONYSCAPE_BUILD_BENCHMARKS=ON and run HarmonyScapeMorphBenchmark.
+ */
+
+#include "../Source/PluginProcessor.h"
+#include "../Source/MorphEngine.h"
+
+// Just the parameters and the morph machinery of the plugin
+class MorphOnlyProcessor : public juce::AudioProcessor
+{
+public:
+    MorphOnlyProcessor()
+        : parameters(*this, nullptr, "Parameters", HarmonyScapeAudioProcessor::createParameterLayout()),
+          parameterSnapshot(parameters),
+          presetBank(parameters),
+          morphEngine(parameters, presetBank, parameterSnapshot)
+    {
+    }
+
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    const juce::String getName() const override { return "MorphOnly"; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return true; }
+    double getTailLengthSeconds() const override { return 0.0; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+    void getStateInformation(juce::MemoryBlock&) override {}
+    void setStateInformation(const void*, int) override {}
+
+    juce::AudioProcessorValueTreeState parameters;
+    ParameterSnapshotManager parameterSnapshot;
+    PresetBank presetBank;
+    MorphEngine morphEngine;
+};
+
+// What a host does for each automated parameter it plays back
+static void setFromHost(juce::AudioProcessorParameter& parameter, float normalisedValue)
+{
+    parameter.setValue(normalisedValue);
+    parameter.sendValueChangedMessageToListeners(normalisedValue);
+}
+
+static double microsecondsSince(juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    constexpr int numSlots = ParameterSnapshot::NUM_MORPH_SLOTS;
+    constexpr int warmUpBlocks = 1000;
+    constexpr int numBlocks = 20000;
+    constexpr int blocksPerSweep = 2000;
+
+    MorphOnlyProcessor processor;
+    const auto& parameterList = processor.getParameters();
+    const int numParameters = parameterList.size();
+
+    // Slot presets with every parameter but the morph's own set at random
+    const auto presetDirectory = juce::File::createTempFile("morphPresets");
+    presetDirectory.createDirectory();
+    juce::Random random(42);
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        juce::XmlElement xml("PARAMETERS");
+        xml.setAttribute("presetName", "Slot " + juce::String(slot + 1));
+
+        for (int i = 0; i < numParameters; ++i)
+        {
+            auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(parameterList[i]);
+            if (parameter == nullptr || processor.parameterSnapshot.getParameterGroup(i) == ParameterSnapshot::Morph)
+                continue;
+
+            auto* child = xml.createNewChildElement("PARAM");
+            child->setAttribute("id", parameter->paramID);
+            child->setAttribute("value", parameter->convertFrom0to1(random.nextFloat()));
+        }
+
+        xml.writeTo(presetDirectory.getChildFile("slot" + juce::String(slot + 1) + ".xml"));
+    }
+
+    processor.presetBank.loadUserPresetsAsync(presetDirectory);
+    std::array<int, numSlots> slots;
+    for (int slot = 0; slot < numSlots; ++slot)
+        slots[static_cast<size_t>(slot)] = FactoryPresets::NUM_PRESETS + slot;
+
+    while (processor.presetBank.getPreset(slots.back()) == nullptr)
+        juce::Thread::sleep(1);
+
+    presetDirectory.deleteRecursively();
+    processor.morphEngine.setSlots(slots);
+    const uint32_t groups = processor.morphEngine.getMorphedGroups();
+
+    // The automation lanes: every morphed parameter whose slots differ
+    std::vector<int> lanes;
+    for (int i = 0; i < numParameters; ++i)
+    {
+        if ((processor.parameterSnapshot.getParameterGroup(i) & groups) == 0)
+            continue;
+
+        const auto* first = processor.presetBank.getPreset(slots.front());
+        for (const int slot : slots)
+            if (!juce::approximatelyEqual(processor.presetBank.getPreset(slot)->values[static_cast<size_t>(i)],
+                                          first->values[static_cast<size_t>(i)]))
+            {
+                lanes.push_back(i);
+                break;
+            }
+    }
+
+    auto* morphParameter = processor.parameters.getParameter("morph");
+    const auto positionAt = [](int block) { return static_cast<float>(block % blocksPerSweep) / (blocksPerSweep - 1); };
+
+    // Morph: one parameter moves, and the morph rewrites the morphed groups
+    const auto morphBlock = [&](int block)
+    {
+        setFromHost(*morphParameter, positionAt(block));
+        processor.parameterSnapshot.update();
+
+        auto& morph = processor.morphEngine;
+        morph.evaluate(processor.parameterSnapshot.get().morphPosition);
+        processor.parameterSnapshot.applyValues(morph.getValues(), groups);
+        processor.parameterSnapshot.setLayerBlend(morph.getUpperValues(), morph.getBlendAmount());
+    };
+
+    // Automation: every lane moves along the same path between the slot presets
+    const auto automationBlock = [&](int block)
+    {
+        const float scaled = positionAt(block) * (numSlots - 1);
+        const int lower = juce::jmin(static_cast<int>(scaled), numSlots - 2);
+        const float t = scaled - static_cast<float>(lower);
+        const auto& from = processor.presetBank.getPreset(slots[static_cast<size_t>(lower)])->values;
+        const auto& to = processor.presetBank.getPreset(slots[static_cast<size_t>(lower + 1)])->values;
+
+        for (const int i : lanes)
+        {
+            const auto index = static_cast<size_t>(i);
+            setFromHost(*parameterList[i], from[index] + (to[index] - from[index]) * t);
+        }
+
+        processor.parameterSnapshot.update();
+    };
+
+    const auto time = [&](auto&& processOneBlock)
+    {
+        for (int block = 0; block < warmUpBlocks; ++block)
+            processOneBlock(block);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+            processOneBlock(block);
+
+        return microsecondsSince(start) / numBlocks;
+    };
+
+    const double morphUs = time(morphBlock);
+    const double automationUs = time(automationBlock);
+
+    std::printf("%d slots, %d parameters, %d differing (automation lanes), %d blocks\n",
+                numSlots, numParameters, static_cast<int>(lanes.size()), numBlocks);
+    std::printf("                     us/block\n");
+    std::printf("morph              %9.2f\n", morphUs);
+    std::printf("automation lanes   %9.2f\n", automationUs);
+    return 0;
+}
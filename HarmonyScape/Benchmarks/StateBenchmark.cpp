@@ -0,0 +1,128 @@
+/*
+ * Times a project load and save of 1000 plugin instances, with the binary state
+ * format and with the XML format it replaced.
+ *
+ * Build with -DHARMONYSCAPE_BUILD_BENCHMARKS=ON and run HarmonyScapeStateBenchmark.
+ */
+
+#include "../Source/PluginProcessor.h"
+#include "../Source/StateSerializer.h"
+
+// Just the parameters of the plugin, so a thousand instances are cheap to create
+class StateOnlyProcessor : public juce::AudioProcessor
+{
+public:
+    StateOnlyProcessor()
+        : parameters(*this, nullptr, "Parameters", HarmonyScapeAudioProcessor::createParameterLayout()),
+          serializer(parameters)
+    {
+    }
+
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    const juce::String getName() const override { return "StateOnly"; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return true; }
+    double getTailLengthSeconds() const override { return 0.0; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+    void getStateInformation(juce::MemoryBlock& destData) override { serializer.save(destData); }
+    void setStateInformation(const void* data, int sizeInBytes) override { serializer.load(data, sizeInBytes); }
+
+    // The format getStateInformation used before the binary state
+    void getXmlState(juce::MemoryBlock& destData)
+    {
+        auto state = parameters.copyState();
+        std::unique_ptr<juce::XmlElement> xml(state.createXml());
+        copyXmlToBinary(*xml, destData);
+    }
+
+    juce::AudioProcessorValueTreeState parameters;
+    StateSerializer serializer;
+};
+
+static double millisecondsSince(juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    constexpr int numInstances = 1000;
+    juce::OwnedArray<StateOnlyProcessor> instances;
+    juce::Random random(42);
+
+    // Every instance gets its own settings, as in a real project
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto* instance = instances.add(new StateOnlyProcessor());
+        for (auto* parameter : instance->getParameters())
+            parameter->setValueNotifyingHost(random.nextFloat());
+    }
+
+    std::vector<juce::MemoryBlock> binaryStates(numInstances), xmlStates(numInstances);
+    std::vector<std::vector<float>> savedValues(numInstances);
+    for (int i = 0; i < numInstances; ++i)
+        for (auto* parameter : instances[i]->getParameters())
+            savedValues[static_cast<size_t>(i)].push_back(parameter->getValue());
+
+    auto start = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numInstances; ++i)
+        instances[i]->getXmlState(xmlStates[static_cast<size_t>(i)]);
+    const double xmlSave = millisecondsSince(start);
+
+    start = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numInstances; ++i)
+        instances[i]->getStateInformation(binaryStates[static_cast<size_t>(i)]);
+    const double binarySave = millisecondsSince(start);
+
+    // Load each state into a different instance, so every load changes values
+    start = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const auto& state = xmlStates[static_cast<size_t>((i + 1) % numInstances)];
+        instances[i]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    }
+    const double xmlLoad = millisecondsSince(start);
+
+    start = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const auto& state = binaryStates[static_cast<size_t>(i)];
+        instances[i]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    }
+    const double binaryLoad = millisecondsSince(start);
+
+    // The binary round trip must restore what each instance saved
+    int mismatches = 0;
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const auto& parameters = instances[i]->getParameters();
+        for (int p = 0; p < parameters.size(); ++p)
+            if (std::abs(parameters[p]->getValue() - savedValues[static_cast<size_t>(i)][static_cast<size_t>(p)]) > 1.0e-5f)
+                ++mismatches;
+    }
+
+    size_t xmlBytes = 0, binaryBytes = 0;
+    for (int i = 0; i < numInstances; ++i)
+    {
+        xmlBytes += xmlStates[static_cast<size_t>(i)].getSize();
+        binaryBytes += binaryStates[static_cast<size_t>(i)].getSize();
+    }
+
+    std::printf("%d instances\n", numInstances);
+    std::printf("          save (ms)   load (ms)   bytes/instance\n");
+    std::printf("XML     %10.2f  %10.2f   %8zu\n", xmlSave, xmlLoad, xmlBytes / numInstances);
+    std::printf("binary  %10.2f  %10.2f   %8zu\n", binarySave, binaryLoad, binaryBytes / numInstances);
+    std::printf("round-trip mismatches: %d\n", mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
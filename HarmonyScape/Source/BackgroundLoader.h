@@ -0,0 +1,68 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <functional>
+
+/**
+ * One worker thread that loads presets and styles for every plugin instance in
+ * the process, so a project with many instances doesn't start a loader thread
+ * for each of them.
+ *
+ * Share it with a juce::SharedResourcePointer<BackgroundLoader>. Jobs run one at a
+ * time in the order they were added. Each job is tagged with its owner, so an
+ * owner going away only drops and waits for its own jobs.
+ */
+class BackgroundLoader
+{
+public:
+    /** Queues a job for owner */
+    void addJob(const void* owner, std::function<void()> job)
+    {
+        pool.addJob(new OwnedJob(owner, std::move(job)), true);
+    }
+
+    /** Drops owner's queued jobs and waits for its running one to finish */
+    void removeJobs(const void* owner)
+    {
+        OwnerSelector selector(owner);
+        pool.removeAllJobs(true, 5000, &selector);
+    }
+
+private:
+    class OwnedJob : public juce::ThreadPoolJob
+    {
+    public:
+        OwnedJob(const void* ownerToUse, std::function<void()> jobToRun)
+            : juce::ThreadPoolJob("BackgroundLoader"), owner(ownerToUse), job(std::move(jobToRun))
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            job();
+            return jobHasFinished;
+        }
+
+        const void* const owner;
+
+    private:
+        std::function<void()> job;
+    };
+
+    class OwnerSelector : public juce::ThreadPool::JobSelector
+    {
+    public:
+        explicit OwnerSelector(const void* ownerToMatch) : owner(ownerToMatch) {}
+
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            auto* ownedJob = dynamic_cast<OwnedJob*>(job);
+            return ownedJob != nullptr && ownedJob->owner == owner;
+        }
+
+    private:
+        const void* owner;
+    };
+
+    juce::ThreadPool pool { 1 };
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+/**
+ * A static part of a component's drawing (background, grid, legend), rendered once
+ * into an image and drawn from it until invalidated.
+ *
+ * The image is rendered at the display's pixel scale, so it stays sharp on high
+ * resolution screens. It is re-rendered when the area or that scale changes, or
+ * after invalidate(); components call invalidate() from resized() and whenever
+ * what the layer shows changes.
+ */
+class CachedLayer
+{
+public:
+    void invalidate() noexcept { image = {}; }
+
+    /**
+     * Draws the layer into area, first calling render to fill it if the cached
+     * image is out of date. render draws in the component's own coordinates.
+     */
+    template <typename RenderFunction>
+    void draw(juce::Graphics& g, juce::Rectangle<int> area, RenderFunction&& render)
+    {
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (image.isNull() || !juce::approximatelyEqual(scale, imageScale) || area != imageArea)
+        {
+            const int width = juce::roundToInt(static_cast<float>(area.getWidth()) * scale);
+            const int height = juce::roundToInt(static_cast<float>(area.getHeight()) * scale);
+            if (width <= 0 || height <= 0)
+                return;
+
+            image = juce::Image(juce::Image::ARGB, width, height, true);
+            imageScale = scale;
+            imageArea = area;
+
+            juce::Graphics layer(image);
+            layer.addTransform(juce::AffineTransform::translation(static_cast<float>(-area.getX()),
+                                                                  static_cast<float>(-area.getY()))
+                                                     .scaled(scale));
+            render(layer);
+        }
+
+        g.drawImage(image, area.toFloat());
+    }
+
+private:
+    juce::Image image;
+    float imageScale = 0.0f;
+    juce::Rectangle<int> imageArea;
+};
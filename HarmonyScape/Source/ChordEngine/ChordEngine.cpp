@@ -1,7 +1,14 @@
 #include "ChordEngine.h"
 
 ChordEngine::ChordEngine()
+    : analyzer([this](const juce::Array<int>& heldNotes, float density, const CompiledVoicingStyle& style,
+                      uint16_t scaleMask, const juce::Array<int>& reference)
+               {
+                   return voiceChord(heldNotes, density, style, scaleMask, reference);
+               })
 {
+    // By default a single omni zone covers the whole keyboard
+    zones[0].config.enabled = true;
 }
 
 ChordEngine::~ChordEngine()
@@ -12,407 +19,547 @@ void ChordEngine::prepare(double newSampleRate, int newSamplesPerBlock)
 {
     sampleRate = newSampleRate;
     samplesPerBlock = newSamplesPerBlock;
+    
+    // Reserve note storage up front so zones don't allocate while playing
+    for (auto& zone : zones)
+    {
+        zone.activeNotes.ensureStorageAllocated(128);
+        zone.currentVoicing.ensureStorageAllocated(VoicingCandidate::MAX_NOTES);
+        zone.lastVoicing.ensureStorageAllocated(VoicingCandidate::MAX_NOTES);
+        zone.nextVoicing.ensureStorageAllocated(VoicingCandidate::MAX_NOTES);
+    }
+    
+    // Nothing is in flight across a prepare, so the window can be applied directly
+    // and reported to the host before playback starts
+    pendingHead = 0;
+    numPendingNotes = 0;
+    blockStartSample = 0;
+    captureWindowSamples = juce::roundToInt(captureWindowMs * sampleRate / 1000.0);
+    keyTracker.reset();
+    
+    analyzer.start();
 }
 
-juce::MidiBuffer ChordEngine::processMidi(const juce::MidiBuffer& midiMessages, float densityParam)
+void ChordEngine::setZoneConfig(int zoneIndex, const ZoneConfig& config)
 {
-    // Track which notes were turned off in this block
-    juce::Array<int> notesOff;
+    if (zoneIndex < 0 || zoneIndex >= MAX_ZONES)
+        return;
+    
+    auto& zone = zones[static_cast<size_t>(zoneIndex)];
+    const auto& current = zone.config;
     
-    // Process incoming MIDI messages to update active notes
-    for (const auto metadata : midiMessages)
+    // Density and style are picked up by processZone, which re-voices when they change
+    zone.needsRelease |= config.enabled != current.enabled || config.outputChannel != current.outputChannel;
+    zone.needsReroute |= config.enabled != current.enabled || config.midiChannel != current.midiChannel
+                      || config.lowestNote != current.lowestNote || config.highestNote != current.highestNote;
+    zone.config = config;
+}
+
+void ChordEngine::processMidi(juce::Span<const NoteEvent> inputEvents, int numSamples, float densityParam,
+                              NoteEventBuffer& outputBuffer)
+{
+    // Latest next-chord predictions from the analysis worker
+    predictions = &analyzer.readPredictions();
+    
+    // Rerouted zones take over the keys still held for them before new input is
+    // routed, and are re-voiced from them below
+    for (auto& zone : zones)
     {
-        auto message = metadata.getMessage();
-        
-        if (message.isNoteOn())
+        if (zone.needsRelease)
         {
-            int noteNumber = message.getNoteNumber();
-            if (!activeNotes.contains(noteNumber))
-                activeNotes.add(noteNumber);
+            releaseZoneVoicing(zone, outputBuffer, 0);
+            zone.needsRelease = false;
+            zone.needsUpdate = !zone.activeNotes.isEmpty();
         }
-        else if (message.isNoteOff())
+        
+        if (zone.needsReroute)
         {
-            int noteNumber = message.getNoteNumber();
-            notesOff.add(noteNumber);
-            activeNotes.removeFirstMatchingValue(noteNumber);
+            rerouteHeldNotes(zone);
+            zone.needsReroute = false;
         }
     }
     
-    // Generate output MIDI buffer with chord voicing
-    juce::MidiBuffer outputBuffer;
+    // A new window length invalidates the due times of everything still queued
+    const int windowSamples = juce::roundToInt(captureWindowMs * sampleRate / 1000.0);
+    if (windowSamples != captureWindowSamples)
+    {
+        flushPendingNotes(outputBuffer);
+        captureWindowSamples = windowSamples;
+    }
     
-    // If any notes were released or no notes are active, turn off ALL generated notes
-    if (notesOff.size() > 0 || activeNotes.size() == 0)
+    if (captureWindowSamples == 0)
     {
-        // Turn off ALL current voicing notes
-        for (int voiceNote : currentVoicing)
+        // No capture window: every note in the block is voiced together at its start
+        for (const auto& event : inputEvents)
         {
-            outputBuffer.addEvent(juce::MidiMessage::noteOff(1, voiceNote, 0.0f), 0);
+            outputBuffer.add(event);
+            routeNote(event.channel, event.noteNumber, event.isNoteOn, event.velocity);
         }
-        currentVoicing.clear();
-        currentChord = Chord(); // Reset current chord
-        return outputBuffer; // Return early - no new notes to generate
+        
+        processZones(densityParam, outputBuffer, 0);
+        blockStartSample += numSamples;
+        return;
     }
     
-    // Detect chord from active notes
-    if (activeNotes.size() >= 1)
+    // Density/style changes and re-voicing after a release happen at the block start
+    processZones(densityParam, outputBuffer, 0);
+    
+    // Queue the note events
+    for (const auto& event : inputEvents)
     {
-        currentChord = detectChord(activeNotes);
+        PendingNote note;
+        note.dueSample = blockStartSample + event.samplePosition + captureWindowSamples;
+        note.channel = event.channel;
+        note.noteNumber = event.noteNumber;
+        note.velocity = event.velocity;
+        note.isNoteOn = event.isNoteOn;
+        
+        if (numPendingNotes == MAX_PENDING_NOTES)
+        {
+            // Queue overflow: hand the event over undelayed rather than lose it
+            outputBuffer.add(event);
+            routeNote(note.channel, note.noteNumber, note.isNoteOn, note.velocity);
+            processZones(densityParam, outputBuffer, event.samplePosition);
+            continue;
+        }
+        
+        pendingNotes[static_cast<size_t>((pendingHead + numPendingNotes) % MAX_PENDING_NOTES)] = note;
+        ++numPendingNotes;
     }
     
-    // Calculate new voicing
-    juce::Array<int> newVoicing;
-    if (!currentChord.isEmpty())
+    // Release events falling due in this block, sample-accurately
+    const juce::int64 blockEndSample = blockStartSample + numSamples;
+    
+    while (numPendingNotes > 0 && pendingNotes[static_cast<size_t>(pendingHead)].dueSample < blockEndSample)
     {
-        newVoicing = generateVoicing(currentChord, densityParam);
+        const auto note = pendingNotes[static_cast<size_t>(pendingHead)];
+        pendingHead = (pendingHead + 1) % MAX_PENDING_NOTES;
+        --numPendingNotes;
         
-        // Turn off notes that are no longer in the voicing
-        for (int voiceNote : currentVoicing)
+        const int samplePosition = static_cast<int>(juce::jmax(juce::int64(0), note.dueSample - blockStartSample));
+        outputBuffer.add(note.toEvent(samplePosition));
+        
+        if (note.captured)
+            continue;
+        
+        routeNote(note.channel, note.noteNumber, note.isNoteOn, note.velocity);
+        
+        // The first note-on of a gesture pulls in every note-on that arrived within
+        // the window after it. Their raw arrival precedes this due time, so they are
+        // already queued; a release ends the gesture.
+        if (note.isNoteOn)
         {
-            if (!newVoicing.contains(voiceNote))
+            for (int i = 0; i < numPendingNotes; ++i)
             {
-                outputBuffer.addEvent(juce::MidiMessage::noteOff(1, voiceNote, 0.0f), 0);
+                auto& next = pendingNotes[static_cast<size_t>((pendingHead + i) % MAX_PENDING_NOTES)];
+                if (!next.isNoteOn || next.dueSample >= note.dueSample + captureWindowSamples)
+                    break;
+                
+                routeNote(next.channel, next.noteNumber, true, next.velocity);
+                next.captured = true;
             }
         }
         
-        // Turn on new notes in the voicing
-        for (int newNote : newVoicing)
+        processZones(densityParam, outputBuffer, samplePosition);
+    }
+    
+    blockStartSample = blockEndSample;
+}
+
+void ChordEngine::flushPendingNotes(NoteEventBuffer& output)
+{
+    while (numPendingNotes > 0)
+    {
+        const auto& note = pendingNotes[static_cast<size_t>(pendingHead)];
+        output.add(note.toEvent(0));
+        
+        if (!note.captured)
+            routeNote(note.channel, note.noteNumber, note.isNoteOn, note.velocity);
+        
+        pendingHead = (pendingHead + 1) % MAX_PENDING_NOTES;
+        --numPendingNotes;
+    }
+}
+
+int ChordEngine::getCurrentChordId() const
+{
+    for (const auto& zone : zones)
+    {
+        if (zone.config.enabled && !zone.currentChord.isEmpty())
+            return zone.currentChord.rootNote % 12 + 12 * static_cast<int>(zone.currentChord.quality);
+    }
+    
+    return -1;
+}
+
+void ChordEngine::routeNote(int channel, int noteNumber, bool isNoteOn, float velocity)
+{
+    // The key estimate follows every note, whichever zones it lands in
+    if (isNoteOn)
+        keyTracker.noteOn(noteNumber, velocity);
+    
+    auto& heldChannels = heldInputChannels[static_cast<size_t>(noteNumber & 127)];
+    const auto channelBit = static_cast<uint16_t>(1 << ((channel - 1) & 15));
+    heldChannels = static_cast<uint16_t>(isNoteOn ? heldChannels | channelBit : heldChannels & ~channelBit);
+    if (isNoteOn)
+        heldInputVelocities[static_cast<size_t>(noteNumber & 127)] = velocity;
+    
+    for (auto& zone : zones)
+    {
+        if (!zone.config.accepts(channel, noteNumber))
+            continue;
+        
+        if (isNoteOn)
         {
-            if (!currentVoicing.contains(newNote))
+            if (!zone.activeNotes.contains(noteNumber))
+                zone.activeNotes.add(noteNumber);
+            zone.velocity = velocity;
+            zone.needsUpdate = true;
+            zone.hadNoteOn = true;
+        }
+        else
+        {
+            zone.activeNotes.removeFirstMatchingValue(noteNumber);
+            zone.hadNoteOff = true;
+        }
+    }
+}
+
+void ChordEngine::rerouteHeldNotes(ZoneState& zone)
+{
+    zone.activeNotes.clearQuick();
+    
+    // The zone plays as loud as the loudest key it takes over
+    float loudest = 0.0f;
+    for (int note = 0; note < 128; ++note)
+    {
+        const int heldChannels = heldInputChannels[static_cast<size_t>(note)];
+        for (int channel = 1; channel <= 16; ++channel)
+        {
+            if ((heldChannels & (1 << (channel - 1))) != 0 && zone.config.accepts(channel, note))
             {
-                outputBuffer.addEvent(juce::MidiMessage::noteOn(1, newNote, 0.6f), 0);
+                zone.activeNotes.add(note);
+                loudest = juce::jmax(loudest, heldInputVelocities[static_cast<size_t>(note)]);
+                break;
             }
         }
     }
     
-    // Update current voicing
-    currentVoicing = newVoicing;
+    if (loudest > 0.0f)
+        zone.velocity = loudest;
     
-    return outputBuffer;
+    // Voiced against what the zone sounds now, so only the notes that differ change
+    zone.needsUpdate = true;
+    zone.hadNoteOff = false;
 }
 
-ChordEngine::Chord ChordEngine::detectChord(const juce::Array<int>& notes)
+void ChordEngine::processZones(float densityParam, NoteEventBuffer& outputBuffer, int samplePosition)
 {
-    if (notes.size() < 1)  // Changed from < 2 to < 1
-        return Chord();
+    const auto& activeStyle = styleLibrary.getActiveStyle();
     
-    // Sort notes in ascending order
-    juce::Array<int> sortedNotes = notes;
-    sortedNotes.sort();
+    for (auto& zone : zones)
+    {
+        if (zone.config.enabled)
+            processZone(zone, densityParam, activeStyle, outputBuffer, samplePosition);
+    }
+}
+
+void ChordEngine::releaseZoneVoicing(ZoneState& zone, NoteEventBuffer& outputBuffer, int samplePosition)
+{
+    // Turn off ALL current voicing notes
+    for (int voiceNote : zone.currentVoicing)
+    {
+        outputBuffer.add(NoteEvent::noteOff(samplePosition, zone.voicingChannel, voiceNote, NoteEvent::Source::Harmony));
+    }
     
-    // Find root note (lowest note for now in MVP)
-    int rootNote = sortedNotes[0];
+    // Remember what was sounding so the next chord can be voice-led from it. The
+    // arrays are swapped rather than copied, so each keeps its reserved storage.
+    if (!zone.currentVoicing.isEmpty())
+        zone.lastVoicing.swapWith(zone.currentVoicing);
     
-    // Handle single notes
-    if (sortedNotes.size() == 1)
+    zone.currentVoicing.clearQuick();
+    zone.currentChord = Chord(); // Reset current chord
+}
+
+void ChordEngine::processZone(ZoneState& zone, float densityParam, const CompiledVoicingStyle& activeStyle,
+                              NoteEventBuffer& outputBuffer, int samplePosition)
+{
+    const auto& config = zone.config;
+    
+    // If any notes were released or no notes are active, turn off ALL generated notes
+    if (zone.hadNoteOff || zone.activeNotes.isEmpty())
     {
-        Chord chord;
-        chord.rootNote = rootNote;
-        chord.notes = sortedNotes;
+        releaseZoneVoicing(zone, outputBuffer, samplePosition);
         
-        // Single note - just name it
-        static const juce::String noteNames[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
-        chord.name = noteNames[rootNote % 12];
-        
-        return chord;
+        // Notes still held are re-voiced on the next block
+        zone.needsUpdate = !zone.activeNotes.isEmpty();
+        zone.hadNoteOff = false;
+        return; // Return early - no new notes to generate
     }
     
-    // Calculate intervals relative to root for multiple notes
-    juce::Array<int> intervals;
-    for (auto note : sortedNotes)
-    {
-        int interval = (note - rootNote) % 12;
-        if (!intervals.contains(interval) && interval > 0)
-            intervals.add(interval);
-    }
+    const float density = config.density >= 0.0f ? config.density : densityParam;
+    const auto& style = config.styleIndex >= 0
+        ? FactoryVoicingStyles::compiled[static_cast<size_t>(juce::jmin(config.styleIndex, FactoryVoicingStyles::NUM_STYLES - 1))]
+        : activeStyle;
     
-    // Create chord based on intervals
-    Chord chord;
-    chord.rootNote = rootNote;
-    chord.notes = sortedNotes;
+    // Nothing changed since the current voicing was generated
+    if (!zone.needsUpdate && juce::approximatelyEqual(density, zone.lastDensity) && &style == zone.lastStyle)
+        return;
+    
+    // Only a chord the player struck is reported to the analyzer: what is left
+    // after lifting keys, or a density or style change, isn't a new chord
+    const bool isNewGesture = zone.hadNoteOn;
+    
+    zone.needsUpdate = false;
+    zone.hadNoteOn = false;
+    zone.lastDensity = density;
+    zone.lastStyle = &style;
+    
+    // Detect chord from active notes
+    zone.currentChord = detectChord(zone.activeNotes);
     
-    // Map intervals to chord name
-    if (matchChordType(intervals, chord.name))
+    // Calculate new voicing
+    auto& newVoicing = zone.nextVoicing;
+    newVoicing.clearQuick();
+    if (!zone.currentChord.isEmpty())
     {
-        // Root note name
-        static const juce::String noteNames[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
-        juce::String rootName = noteNames[rootNote % 12];
+        const auto& referenceVoicing = zone.currentVoicing.isEmpty() ? zone.lastVoicing : zone.currentVoicing;
+        const uint16_t scaleMask = keyTracker.getScaleMask();
+        const int zoneIndex = static_cast<int>(&zone - zones.data());
+        const auto& heldNotes = zone.currentChord.notes;
+        
+        const auto* predicted = predictions != nullptr
+            ? predictions->find(zoneIndex, heldNotes, densityToLevel(density), &style, scaleMask, referenceVoicing)
+            : nullptr;
+        
+        if (predicted != nullptr)
+        {
+            // The worker already voiced this chord from the same reference
+            for (int i = 0; i < predicted->numNotes; ++i)
+                newVoicing.add(predicted->notes[i]);
+            predictionHits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            generateVoicing(zone.currentChord, density, style, scaleMask, newVoicing);
+            
+            // Re-voice the new chord to move as little as possible from what was last heard
+            voiceLeading.findBestVoicing(referenceVoicing, newVoicing);
+            predictionMisses.fetch_add(1, std::memory_order_relaxed);
+        }
         
-        // Combine root name with chord type
-        chord.name = rootName + chord.name;
+        // Let the worker learn the progression and prepare the likely next chords
+        if (isNewGesture)
+        {
+            HarmonyAnalyzer::VoicedChord voiced;
+            voiced.heldNotes = heldNotes;
+            voiced.style = &style;
+            voiced.density = density;
+            voiced.scaleMask = scaleMask;
+            voiced.zone = static_cast<uint8_t>(zoneIndex);
+            const int numNotes = juce::jmin(newVoicing.size(), HarmonyAnalyzer::MAX_NOTES);
+            voiced.numNotes = static_cast<uint8_t>(numNotes);
+            for (int i = 0; i < numNotes; ++i)
+                voiced.notes[i] = static_cast<uint8_t>(newVoicing.getUnchecked(i));
+            analyzer.pushChord(voiced);
+        }
+        
+        // Turn off notes that are no longer in the voicing
+        for (int voiceNote : zone.currentVoicing)
+        {
+            if (!newVoicing.contains(voiceNote))
+            {
+                outputBuffer.add(NoteEvent::noteOff(samplePosition, zone.voicingChannel, voiceNote, NoteEvent::Source::Harmony));
+            }
+        }
+        
+        // Turn on new notes in the voicing at the playing velocity, each tagged with
+        // its place from the bottom
+        for (int newNote : newVoicing)
+        {
+            if (!zone.currentVoicing.contains(newNote))
+            {
+                int chordPosition = 0;
+                for (int other : newVoicing)
+                    chordPosition += other < newNote ? 1 : 0;
+                
+                outputBuffer.add(NoteEvent::noteOn(samplePosition, config.outputChannel, newNote, zone.velocity,
+                                                   NoteEvent::Source::Harmony, chordPosition));
+            }
+        }
     }
-    else
+    
+    // The new voicing becomes the current one; swapped, so no storage is reallocated
+    zone.currentVoicing.swapWith(newVoicing);
+    zone.voicingChannel = config.outputChannel;
+}
+
+juce::Array<int> ChordEngine::voiceChord(const juce::Array<int>& heldNotes, float density, const CompiledVoicingStyle& style,
+                                         uint16_t scaleMask, const juce::Array<int>& reference) const
+{
+    const auto chord = detectChord(heldNotes);
+    if (chord.isEmpty())
+        return {};
+    
+    juce::Array<int> voicing;
+    generateVoicing(chord, density, style, scaleMask, voicing);
+    voiceLeading.findBestVoicing(reference, voicing);
+    return voicing;
+}
+
+ChordEngine::Chord ChordEngine::detectChord(const juce::Array<int>& notes)
+{
+    Chord chord;
+    if (notes.isEmpty())
+        return chord;
+    
+    // Find root note (lowest note for now in MVP)
+    int rootNote = 127;
+    for (int note : notes)
+        rootNote = juce::jmin(rootNote, note);
+    
+    // Held notes, their pitch classes and their intervals above the root
+    uint16_t intervals = 0;
+    for (int note : notes)
     {
-        // Default to just a collection of notes if we can't identify the chord
-        chord.name = "Unknown";
+        chord.notes.add(note);
+        chord.pitchClasses = static_cast<uint16_t>(chord.pitchClasses | (1 << (note % 12)));
+        intervals = static_cast<uint16_t>(intervals | (1 << ((note - rootNote) % 12)));
     }
     
+    chord.rootNote = rootNote;
+    
+    // A single note implies no quality; otherwise the intervals pick one, or Unknown
+    chord.quality = notes.size() == 1 ? ChordQuality::Single : matchChordType(intervals);
     return chord;
 }
 
-bool ChordEngine::matchChordType(const juce::Array<int>& intervals, juce::String& chordName)
+ChordQuality ChordEngine::matchChordType(uint16_t intervals)
 {
     // Basic chord type recognition based on interval pattern
     // MVP implementation with limited chord types
+    const auto contains = [intervals](int interval) { return (intervals & (1 << interval)) != 0; };
     
-    if (intervals.contains(4) && intervals.contains(7))
+    if (contains(4) && contains(7))
     {
         // Major chord
-        if (intervals.contains(11))
-            chordName = "maj7";
-        else if (intervals.contains(10))
-            chordName = "7";
-        else
-            chordName = "maj";
-        return true;
+        if (contains(11))
+            return ChordQuality::Major7;
+        
+        if (contains(10))
+            return ChordQuality::Dominant7;
+        
+        return ChordQuality::Major;
     }
-    else if (intervals.contains(3) && intervals.contains(7))
+    
+    if (contains(3) && contains(7))
     {
         // Minor chord
-        if (intervals.contains(10))
-            chordName = "m7";
-        else
-            chordName = "m";
-        return true;
+        return contains(10) ? ChordQuality::Minor7 : ChordQuality::Minor;
     }
-    else if (intervals.contains(3) && intervals.contains(6))
+    
+    if (contains(3) && contains(6))
     {
         // Diminished chord
-        if (intervals.contains(9))
-            chordName = "dim7";
-        else
-            chordName = "dim";
-        return true;
-    }
-    else if (intervals.contains(4) && intervals.contains(8))
-    {
-        // Augmented chord
-        chordName = "aug";
-        return true;
-    }
-    else if (intervals.contains(5) && intervals.contains(7))
-    {
-        // Sus4 chord
-        chordName = "sus4";
-        return true;
+        return contains(9) ? ChordQuality::Diminished7 : ChordQuality::Diminished;
     }
     
+    if (contains(4) && contains(8))
+        return ChordQuality::Augmented;
+    
+    if (contains(5) && contains(7))
+        return ChordQuality::Sus4;
+    
     // Unknown chord type
-    chordName = "";
-    return false;
+    return ChordQuality::Unknown;
 }
 
-juce::Array<int> ChordEngine::generateVoicing(const Chord& chord, float density)
+void ChordEngine::generateVoicing(const Chord& chord, float density, const CompiledVoicingStyle& style,
+                                  uint16_t scaleMask, juce::Array<int>& voicing)
 {
-    juce::Array<int> voicing;
+    voicing.clearQuick();
     
     if (chord.isEmpty())
-        return voicing;
+        return;
+    
+    // Minimum interval allowed above a note, by register, to keep the low end clear
+    static constexpr auto lowIntervalLimits = []
+    {
+        std::array<uint8_t, 128> limits {};
+        for (int note = 0; note < 128; ++note)
+            limits[static_cast<size_t>(note)] = note < 40 ? 7 : (note < 48 ? 5 : (note < 55 ? 3 : 1));
+        return limits;
+    }();
     
-    // For single notes, generate more colorful and contextual harmony
-    if (chord.notes.size() == 1)
+    // Candidates arrive pre-ranked by the style; only register fit is evaluated here
+    const int densityLevel = densityToLevel(density);
+    const auto* candidates = VoicingDictionary::getCandidates(chord.quality, densityLevel);
+    const auto& styleEntry = style.getEntry(chord.quality, densityLevel);
+    const int rootNote = chord.rootNote;
+    
+    // Pitch classes the player is holding are never treated as out of key
+    const uint16_t chordMask = chord.pitchClasses;
+    
+    int bestIndex = -1;
+    int bestCost = std::numeric_limits<int>::max();
+    
+    for (int rank = 0; rank < styleEntry.numCandidates; ++rank)
     {
-        int root = chord.notes[0];
-        int rootPitchClass = root % 12;
+        const int c = styleEntry.order[rank];
+        const auto& candidate = candidates[c];
         
-        // Create different harmonic colors based on the root note and density
-        // Lower density = simpler harmonies, higher density = more complex
+        int cost = styleEntry.scores[rank];
+        int previousNote = rootNote;
         
-        if (density < 0.33f)
+        for (int i = 0; i < candidate.numNotes; ++i)
         {
-            // Simple: Just add a fifth for a power chord feel
-            voicing.add(root + 7);  // Perfect fifth
+            const int note = rootNote + candidate.offsets[i];
             
-            // Only add low octave if the root is not already too low
-            if (root > 48 && root < 72) // Avoid mud in low register
-                voicing.add(root - 12);
-        }
-        else if (density < 0.66f)
-        {
-            // Medium: Create sus2/sus4 ambiguity for color
-            // Avoid too many notes in the low register
-            if (root < 48) // Low notes
+            // Notes outside the usable range would be dropped, so the voicing gets thinner
+            if (note < 36 || note > 108)
             {
-                voicing.add(root + 7);   // Perfect fifth
-                voicing.add(root + 12);  // Octave
-                voicing.add(root + 14);  // Major ninth
+                cost += 16;
+                continue;
             }
-            else // Mid to high notes
-            {
-                voicing.add(root + 2);   // Major second (sus2)
-                voicing.add(root + 7);   // Perfect fifth
-                voicing.add(root + 12);  // Octave
-                
-                // Add some shimmer in the upper register
-                if (root < 72)
-                {
-                    voicing.add(root + 14); // Major ninth
-                    voicing.add(root + 19); // Perfect fifth + octave
-                }
-            }
-        }
-        else
-        {
-            // Complex: Create a rich, jazz-influenced stack
-            // Use different voicings based on the pitch class for variety
-            // But avoid clustering in low frequencies
             
-            if (root < 48) // Low register - use wider spacing
+            // Notes the player already holds add nothing to the voicing
+            if (chord.notes.contains(note))
             {
-                switch (rootPitchClass)
-                {
-                    case 0:  // C
-                    case 5:  // F
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 16);  // Major third + octave
-                        voicing.add(root + 23);  // Major seventh + octave
-                        break;
-                        
-                    case 2:  // D
-                    case 7:  // G
-                    case 9:  // A
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 15);  // Minor third + octave
-                        voicing.add(root + 22);  // Minor seventh + octave
-                        break;
-                        
-                    default:
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 12);  // Octave
-                        voicing.add(root + 19);  // Fifth + octave
-                        break;
-                }
-            }
-            else // Mid to high register - normal voicings
-            {
-                switch (rootPitchClass)
-                {
-                    case 0:  // C - Cmaj9#11
-                    case 5:  // F - Fmaj9#11
-                        voicing.add(root + 4);   // Major third
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 11);  // Major seventh
-                        voicing.add(root + 14);  // Major ninth
-                        if (root < 72)
-                            voicing.add(root + 18);  // #11
-                        break;
-                        
-                    case 2:  // D - Dm11
-                    case 7:  // G - Gm11
-                    case 9:  // A - Am11
-                        voicing.add(root + 3);   // Minor third
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 10);  // Minor seventh
-                        voicing.add(root + 14);  // Major ninth
-                        if (root < 72)
-                            voicing.add(root + 17);  // Perfect 11th
-                        break;
-                        
-                    case 4:  // E - E7#9
-                    case 11: // B - B7#9
-                        voicing.add(root + 4);   // Major third
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 10);  // Minor seventh
-                        voicing.add(root + 15);  // #9
-                        break;
-                        
-                    default: // Others - sus4add9
-                        voicing.add(root + 5);   // Perfect fourth
-                        voicing.add(root + 7);   // Perfect fifth
-                        voicing.add(root + 14);  // Major ninth
-                        voicing.add(root + 12);  // Octave
-                        break;
-                }
-                
-                // Only add bass notes if we're in a good range
-                if (root > 60 && root < 84 && voicing.size() < 6)
-                {
-                    voicing.add(root - 12); // Octave below
-                }
-            }
-        }
-    }
-    else
-    {
-        // For chord input, be more selective about what we add
-        // Focus on color tones and upper extensions rather than just octaves
-        
-        int rootNote = chord.rootNote;
-        bool hasThird = false;
-        bool hasSeventh = false;
-        
-        // Analyze what's in the chord already
-        for (auto note : chord.notes)
-        {
-            int interval = (note - rootNote) % 12;
-            if (interval == 3 || interval == 4) hasThird = true;
-            if (interval == 10 || interval == 11) hasSeventh = true;
-        }
-        
-        if (density < 0.33f)
-        {
-            // Light: Just add some sparkle on top
-            if (rootNote + 24 < 108 && rootNote > 36)
-                voicing.add(rootNote + 24); // Two octaves up
-                
-            // Only add bass if root is in mid range
-            if (rootNote > 48 && rootNote < 72)
-                voicing.add(rootNote - 12);
-        }
-        else if (density < 0.66f)
-        {
-            // Medium: Add color tones
-            if (!hasSeventh && rootNote + 11 < 108)
-                voicing.add(rootNote + 11); // Add major 7th for color
-                
-            // Add 9th for shimmer
-            if (rootNote + 14 < 108)
-                voicing.add(rootNote + 14);
-                
-            // Add some upper structure, but avoid too many low notes
-            for (auto note : chord.notes)
-            {
-                if (note > 48 && note + 12 < 96 && voicing.size() < 4)
-                    voicing.add(note + 12);
-            }
-        }
-        else
-        {
-            // Complex: Build rich upper structure triads
-            // Avoid adding too many notes below middle C (60)
-            if (chord.name.contains("maj") && rootNote > 36)
-            {
-                if (rootNote + 14 < 108) voicing.add(rootNote + 14); // 9th
-                if (rootNote + 18 < 108) voicing.add(rootNote + 18); // #11
-                if (rootNote + 21 < 108) voicing.add(rootNote + 21); // 13th
-            }
-            else if (chord.name.contains("m") && rootNote > 36)
-            {
-                if (rootNote + 14 < 108) voicing.add(rootNote + 14); // 9th
-                if (rootNote + 17 < 108) voicing.add(rootNote + 17); // 11th
-                if (rootNote + 20 < 108) voicing.add(rootNote + 20); // b13
-            }
-            else if (chord.name.contains("7") && rootNote > 36)
-            {
-                if (rootNote + 14 < 108) voicing.add(rootNote + 14); // 9th
-                if (rootNote + 16 < 108) voicing.add(rootNote + 16); // #9
-                if (rootNote + 21 < 108) voicing.add(rootNote + 21); // 13th
+                cost += 12;
+                continue;
             }
             
-            // Only add bass notes if we're in an appropriate range
-            if (rootNote > 48 && rootNote < 72)
-            {
-                voicing.add(rootNote - 12); // Root an octave down
-            }
+            // Prefer extensions that belong to the current key
+            const uint16_t pitchClassBit = static_cast<uint16_t>(1 << (note % 12));
+            if (scaleMask != 0 && (scaleMask & pitchClassBit) == 0 && (chordMask & pitchClassBit) == 0)
+                cost += 10;
+            
+            // Penalise muddy close intervals in the low register
+            const int lower = juce::jmin(note, previousNote);
+            const int gap = std::abs(note - previousNote);
+            if (gap > 0 && gap < lowIntervalLimits[static_cast<size_t>(juce::jlimit(0, 127, lower))])
+                cost += 8;
+            
+            previousNote = note;
         }
         
-        // Remove any notes that might clash or are out of reasonable range
-        for (int i = voicing.size() - 1; i >= 0; --i)
+        if (cost < bestCost)
         {
-            if (voicing[i] < 36 || voicing[i] > 108) // Tighter range to avoid mud
-                voicing.remove(i);
+            bestCost = cost;
+            bestIndex = c;
         }
     }
     
-    return voicing;
-} 
\ No newline at end of file
+    if (bestIndex < 0)
+        return;
+    
+    const auto& best = candidates[bestIndex];
+    for (int i = 0; i < best.numNotes; ++i)
+    {
+        const int note = rootNote + best.offsets[i];
+        
+        // Skip notes out of range or already held by the player
+        if (note >= 36 && note <= 108 && !chord.notes.contains(note))
+            voicing.add(note);
+    }
+}
@@ -1,10 +1,23 @@
 #pragma once
 
 #include "../JuceHeader.h"
+#include "../NoteEvent.h"
+#include "ChordTypes.h"
+#include "VoicingDictionary.h"
+#include "VoicingStyles.h"
+#include "VoiceLeading.h"
+#include "KeyTracker.h"
+#include "HarmonyAnalyzer.h"
 
 /**
  * ChordEngine handles chord recognition and voicing.
  * It analyzes MIDI input to detect chords and generates appropriate voicings.
+ * Input can be split into up to MAX_ZONES zones (by MIDI channel and key range),
+ * each voiced independently with its own density and style.
+ *
+ * Recognition, voicing and voice leading on the audio thread don't allocate:
+ * chords are plain data, and each zone's voicings live in arrays reserved in
+ * prepare that are filled in place and swapped rather than copied.
  */
 class ChordEngine
 {
@@ -17,22 +30,102 @@ public:
      */
     void prepare(double sampleRate, int samplesPerBlock);
     
+    // Maximum number of independent keyboard/channel zones
+    static constexpr int MAX_ZONES = 16;
+    
+    /**
+     * Configuration of one chord zone. A zone listens to a MIDI channel and key
+     * range and keeps its own held notes, chord and voicing.
+     */
+    struct ZoneConfig
+    {
+        bool enabled = false;
+        int midiChannel = 0;          // 0 = omni, 1-16 = only this channel
+        int lowestNote = 0;           // Key range (inclusive)
+        int highestNote = 127;
+        float density = -1.0f;        // < 0 follows the global density parameter
+        int styleIndex = -1;          // < 0 follows the library's active style, else a factory style
+        int outputChannel = 1;        // Channel for the generated voicing
+        
+        bool accepts(int channel, int noteNumber) const
+        {
+            return enabled
+                && (midiChannel == 0 || midiChannel == channel)
+                && noteNumber >= lowestNote && noteNumber <= highestNote;
+        }
+    };
+    
     /**
      * Process incoming MIDI data, recognize chords and generate voicings
-     * @param midiMessages Incoming MIDI buffer
+     * @param inputEvents The block's decoded input notes, in sample order
+     * @param numSamples Length of the current block
      * @param densityParam Chord density parameter (0.0-1.0)
-     * @return Generated chord voices as a MIDI buffer
+     * @param output Receives the input notes, delayed to line up with the generated
+     *               voicings (identical to the input when the capture window is off),
+     *               and the generated voice changes as Harmony events. Appended.
+     */
+    void processMidi(juce::Span<const NoteEvent> inputEvents, int numSamples, float densityParam,
+                     NoteEventBuffer& output);
+    
+    /**
+     * Sets the strum capture window in milliseconds (0 disables it). With a window,
+     * note-ons arriving within it of a gesture's first note-on are voiced as one
+     * chord. All input is delayed by the window, which becomes the engine's latency.
+     * Takes effect on the next processMidi call.
      */
-    juce::MidiBuffer processMidi(const juce::MidiBuffer& midiMessages, float densityParam);
+    void setCaptureWindow(double milliseconds) { captureWindowMs = juce::jmax(0.0, milliseconds); }
     
     /**
-     * Represents a recognized chord
+     * Latency introduced by the capture window, in samples
+     */
+    int getLatencySamples() const { return captureWindowSamples; }
+    
+    /**
+     * Replaces a zone's configuration; unchanged settings cost nothing. A new density
+     * or style re-voices the held chord in place. A new channel or key range hands the
+     * keys still held over to the zones that now accept them, on the next processMidi
+     * call. Only a new output channel, or disabling the zone, releases its voicing.
+     * Call from the audio thread or while not processing.
+     */
+    void setZoneConfig(int zoneIndex, const ZoneConfig& config);
+    
+    /**
+     * Returns a zone's configuration
+     */
+    const ZoneConfig& getZoneConfig(int zoneIndex) const { return zones[static_cast<size_t>(juce::jlimit(0, MAX_ZONES - 1, zoneIndex))].config; }
+    
+    /**
+     * Access to the voicing style library (factory style selection, user style loading)
+     */
+    VoicingStyleLibrary& getStyleLibrary() { return styleLibrary; }
+    
+    /**
+     * Key estimate from the incoming notes
+     */
+    const KeyTracker& getKeyTracker() const { return keyTracker; }
+    
+    /**
+     * Voicings served from the analysis worker's predictions vs. computed in place
+     */
+    uint32_t getPredictionHits() const { return predictionHits.load(std::memory_order_relaxed); }
+    uint32_t getPredictionMisses() const { return predictionMisses.load(std::memory_order_relaxed); }
+    
+    /**
+     * Compact identity of the chord held in the first zone that has one, for
+     * display: root pitch class + 12 * quality, or -1 if no chord is held
+     */
+    int getCurrentChordId() const;
+    
+    /**
+     * Represents a recognized chord. Plain data, so recognising one on the audio
+     * thread doesn't allocate.
      */
     struct Chord
     {
-        juce::String name;           // e.g., "Cmaj7"
         int rootNote = 60;           // MIDI note number (C4 = 60)
-        juce::Array<int> notes;      // MIDI note numbers of chord tones
+        HarmonyAnalyzer::NoteMask notes;    // Held MIDI notes
+        uint16_t pitchClasses = 0;   // 12-bit mask of the held pitch classes
+        ChordQuality quality = ChordQuality::Unknown; // Recognised quality, indexes the voicing dictionary
         
         bool isEmpty() const { return notes.isEmpty(); }
     };
@@ -41,22 +134,138 @@ private:
     /**
      * Analyzes active notes to detect the chord
      */
-    Chord detectChord(const juce::Array<int>& activeNotes);
+    static Chord detectChord(const juce::Array<int>& activeNotes);
     
     /**
-     * Generates appropriate voicings for the detected chord
+     * Generates appropriate voicings for the detected chord.
+     * Candidates come from the precomputed VoicingDictionary for the chord's
+     * quality and density level, in the order given by the voicing style;
+     * only register fit and, when a key is known, diatonic fit are ranked at runtime.
+     * @param scaleMask 12-bit scale of the current key, or 0 if unknown
+     * @param voicing Receives the voicing; it is cleared and filled without growing
+     *        past VoicingCandidate::MAX_NOTES, so reserved storage is never reallocated
      */
-    juce::Array<int> generateVoicing(const Chord& chord, float density);
+    static void generateVoicing(const Chord& chord, float density, const CompiledVoicingStyle& style,
+                                uint16_t scaleMask, juce::Array<int>& voicing);
+    
+    /**
+     * Detection, voicing and voice leading in one step. Thread-safe; the analysis
+     * worker uses it to prepare predicted chords with exactly the same rules.
+     */
+    juce::Array<int> voiceChord(const juce::Array<int>& heldNotes, float density, const CompiledVoicingStyle& style,
+                                uint16_t scaleMask, const juce::Array<int>& reference) const;
     
     /**
      * Maps intervals to chord types for recognition
+     * @param intervals 12-bit mask of the intervals above the root
+     */
+    static ChordQuality matchChordType(uint16_t intervals);
+    
+    /**
+     * Per-zone performance state. Recognition, dictionary and style tables are
+     * shared, so a zone is only its held notes and voicings.
+     */
+    struct ZoneState
+    {
+        ZoneConfig config;
+        juce::Array<int> activeNotes;
+        Chord currentChord;
+        juce::Array<int> currentVoicing;
+        juce::Array<int> lastVoicing;    // Last voicing that sounded, kept across releases for voice leading
+        juce::Array<int> nextVoicing;    // Scratch for the voicing being generated
+        int voicingChannel = 1;          // Output channel the current voicing was started on
+        float velocity = 0.0f;           // Latest key velocity; new harmony notes play at it
+        
+        bool hadNoteOn = false;          // Keys were struck since the voicing was generated
+        bool hadNoteOff = false;         // A held note was released this block
+        bool needsUpdate = false;        // Held notes changed since the voicing was generated
+        bool needsRelease = false;       // Output channel changed or zone disabled: release the voicing
+        bool needsReroute = false;       // Channel or key range changed: re-collect the held keys
+        float lastDensity = -1.0f;       // Density/style the voicing was generated with
+        const CompiledVoicingStyle* lastStyle = nullptr;
+    };
+    
+    /**
+     * Updates one zone's voicing and appends the resulting note changes
+     */
+    void processZone(ZoneState& zone, float densityParam, const CompiledVoicingStyle& activeStyle,
+                     NoteEventBuffer& outputBuffer, int samplePosition);
+    
+    /**
+     * Runs processZone on every enabled zone
+     */
+    void processZones(float densityParam, NoteEventBuffer& outputBuffer, int samplePosition);
+    
+    /**
+     * Releases every note of a zone's current voicing
      */
-    bool matchChordType(const juce::Array<int>& intervals, juce::String& chordName);
+    void releaseZoneVoicing(ZoneState& zone, NoteEventBuffer& outputBuffer, int samplePosition);
+    
+    /**
+     * Hands a note event to every zone that listens to it
+     */
+    void routeNote(int channel, int noteNumber, bool isNoteOn, float velocity);
+    
+    /**
+     * Replaces a zone's held notes with the held input keys its config accepts
+     */
+    void rerouteHeldNotes(ZoneState& zone);
+    
+    /**
+     * A note event held back by the capture window
+     */
+    struct PendingNote
+    {
+        juce::int64 dueSample = 0;       // Absolute sample at which the event is released
+        uint8_t channel = 1;
+        uint8_t noteNumber = 0;
+        float velocity = 0.0f;
+        bool isNoteOn = false;
+        bool captured = false;           // Already voiced as part of an earlier note-on's gesture
+        
+        NoteEvent toEvent(int samplePosition) const
+        {
+            return isNoteOn ? NoteEvent::noteOn(samplePosition, channel, noteNumber, velocity, NoteEvent::Source::Input)
+                            : NoteEvent::noteOff(samplePosition, channel, noteNumber, NoteEvent::Source::Input);
+        }
+    };
+    
+    /**
+     * Routes every pending note at the start of the block (window changes)
+     */
+    void flushPendingNotes(NoteEventBuffer& output);
     
     // Engine state
-    juce::Array<int> activeNotes;
-    Chord currentChord;
-    juce::Array<int> currentVoicing;
+    std::array<ZoneState, MAX_ZONES> zones;
+    
+    // Input channels (bit n = channel n + 1) holding each key, as routed to the zones
+    std::array<uint16_t, 128> heldInputChannels {};
+    std::array<float, 128> heldInputVelocities {};
+    
+    // Voice-leading stage between consecutive voicings
+    VoiceLeadingOptimizer voiceLeading;
+    
+    // Published voicing style tables
+    VoicingStyleLibrary styleLibrary;
+    
+    // Running key estimate shared by all zones
+    KeyTracker keyTracker;
+    
+    // Background progression analysis; predictions are read once per block
+    HarmonyAnalyzer analyzer;
+    const HarmonyAnalyzer::Snapshot* predictions = nullptr;
+    std::atomic<uint32_t> predictionHits { 0 };
+    std::atomic<uint32_t> predictionMisses { 0 };
+    
+    // Strum capture: a FIFO of delayed note events (due times are ascending because
+    // every event is delayed by the same amount)
+    static constexpr int MAX_PENDING_NOTES = 1024;
+    std::array<PendingNote, MAX_PENDING_NOTES> pendingNotes;
+    int pendingHead = 0;
+    int numPendingNotes = 0;
+    juce::int64 blockStartSample = 0;
+    double captureWindowMs = 0.0;
+    int captureWindowSamples = 0;
     
     // Cached parameters
     double sampleRate = 44100.0;
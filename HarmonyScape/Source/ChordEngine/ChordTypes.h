@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Chord qualities recognised by the ChordEngine.
+ * The numeric values index the precomputed voicing tables, so new qualities
+ * must be appended before NumQualities.
+ */
+enum class ChordQuality : uint8_t
+{
+    Single,       // Single note, no quality implied
+    Major,
+    Minor,
+    Dominant7,
+    Major7,
+    Minor7,
+    Diminished,
+    Diminished7,
+    Augmented,
+    Sus4,
+    Unknown,      // Notes that don't match any known pattern
+    NumQualities
+};
+
+static constexpr int NUM_CHORD_QUALITIES = static_cast<int>(ChordQuality::NumQualities);
+
+/**
+ * Chord density is quantised into levels when choosing voicings.
+ * Thresholds match the original density bands (< 0.33, < 0.66, above).
+ */
+static constexpr int NUM_DENSITY_LEVELS = 3;
+
+inline int densityToLevel(float density)
+{
+    if (density < 0.33f)
+        return 0;
+    if (density < 0.66f)
+        return 1;
+    return 2;
+}
@@ -0,0 +1,244 @@
+#include "HarmonyAnalyzer.h"
+
+HarmonyAnalyzer::NoteMask HarmonyAnalyzer::NoteMask::transposed(int semitones) const
+{
+    NoteMask result;
+
+    for (int note = 0; note < 128; ++note)
+    {
+        if ((bits[note >> 6] & (uint64_t(1) << (note & 63))) == 0)
+            continue;
+
+        const int shifted = note + semitones;
+        if (shifted < 0 || shifted > 127)
+            return {};
+
+        result.add(shifted);
+    }
+
+    return result;
+}
+
+const HarmonyAnalyzer::VoicedChord* HarmonyAnalyzer::Snapshot::find(int zone, const NoteMask& heldNotes, int densityLevel,
+                                                                    const CompiledVoicingStyle* style, uint16_t scaleMask,
+                                                                    const juce::Array<int>& reference) const
+{
+    if (zone < 0 || zone >= MAX_ZONES || reference.size() > MAX_NOTES)
+        return nullptr;
+
+    for (const auto& prediction : predictions[static_cast<size_t>(zone)])
+    {
+        if (prediction.numNotes == 0
+            || prediction.heldNotes != heldNotes
+            || prediction.style != style
+            || prediction.scaleMask != scaleMask
+            || densityToLevel(prediction.density) != densityLevel
+            || prediction.numReference != reference.size())
+            continue;
+
+        bool sameReference = true;
+        for (int i = 0; i < reference.size() && sameReference; ++i)
+            sameReference = prediction.reference[i] == reference.getUnchecked(i);
+
+        if (sameReference)
+            return &prediction;
+    }
+
+    return nullptr;
+}
+
+HarmonyAnalyzer::HarmonyAnalyzer(VoicingFunction voicingFunction)
+    : juce::Thread("HarmonyScape Analysis"),
+      voiceChord(std::move(voicingFunction))
+{
+    previousShape.fill(-1);
+}
+
+HarmonyAnalyzer::~HarmonyAnalyzer()
+{
+    stopThread(2000);
+}
+
+void HarmonyAnalyzer::start()
+{
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+}
+
+void HarmonyAnalyzer::pushChord(const VoicedChord& chord)
+{
+    const auto scope = queueFifo.write(1);
+
+    if (scope.blockSize1 > 0)
+        queue[static_cast<size_t>(scope.startIndex1)] = chord;
+}
+
+void HarmonyAnalyzer::run()
+{
+    while (!threadShouldExit())
+    {
+        bool updated = false;
+
+        while (queueFifo.getNumReady() > 0)
+        {
+            VoicedChord chord;
+            {
+                const auto scope = queueFifo.read(1);
+                chord = queue[static_cast<size_t>(scope.startIndex1)];
+            }
+
+            analyse(chord);
+            updated = true;
+        }
+
+        if (updated)
+        {
+            snapshots.getWriteBuffer() = latest;
+            snapshots.publish();
+        }
+
+        // Sleeps until the next poll; stopping the thread wakes it early
+        wait(POLL_INTERVAL_MS);
+    }
+}
+
+int HarmonyAnalyzer::findOrAddShape(const NoteMask& shape)
+{
+    for (int i = 0; i < numShapes; ++i)
+        if (shapes[static_cast<size_t>(i)] == shape)
+            return i;
+
+    int slot = numShapes;
+
+    if (numShapes < MAX_SHAPES)
+    {
+        ++numShapes;
+    }
+    else
+    {
+        // Recycle the least recently played shape and forget its transitions
+        slot = 0;
+        for (int i = 1; i < MAX_SHAPES; ++i)
+            if (shapeLastUsed[static_cast<size_t>(i)] < shapeLastUsed[static_cast<size_t>(slot)])
+                slot = i;
+
+        transitions[static_cast<size_t>(slot)].fill(0.0f);
+        for (auto& row : transitions)
+            row[static_cast<size_t>(slot)] = 0.0f;
+
+        for (auto& previous : previousShape)
+            if (previous == slot)
+                previous = -1;
+    }
+
+    shapes[static_cast<size_t>(slot)] = shape;
+    return slot;
+}
+
+void HarmonyAnalyzer::analyse(const VoicedChord& chord)
+{
+    if (chord.zone >= MAX_ZONES || chord.style == nullptr || chord.heldNotes.isEmpty())
+        return;
+
+    const int shape = findOrAddShape(chord.heldNotes);
+    shapeLastUsed[static_cast<size_t>(shape)] = ++eventCounter;
+
+    // Learn the transition from the zone's previous chord
+    auto& previous = previousShape[chord.zone];
+    if (previous >= 0 && previous != shape)
+    {
+        auto& row = transitions[static_cast<size_t>(previous)];
+        row[static_cast<size_t>(shape)] += 1.0f;
+
+        // Keep rows adaptive: old habits fade as new ones are counted
+        float total = 0.0f;
+        for (float count : row)
+            total += count;
+        if (total > 32.0f)
+            for (auto& count : row)
+                count *= 0.5f;
+    }
+    previous = shape;
+
+    // Most likely successors first, then root moves by a fourth and a fifth as a prior
+    std::array<NoteMask, PREDICTIONS_PER_ZONE> candidates {};
+    int numCandidates = 0;
+
+    auto addCandidate = [&](const NoteMask& candidate)
+    {
+        if (candidate.isEmpty() || candidate == chord.heldNotes || numCandidates >= PREDICTIONS_PER_ZONE)
+            return;
+
+        for (int i = 0; i < numCandidates; ++i)
+            if (candidates[static_cast<size_t>(i)] == candidate)
+                return;
+
+        candidates[static_cast<size_t>(numCandidates++)] = candidate;
+    };
+
+    const auto& row = transitions[static_cast<size_t>(shape)];
+    for (int pick = 0; pick < PREDICTIONS_PER_ZONE; ++pick)
+    {
+        int best = -1;
+        for (int i = 0; i < numShapes; ++i)
+        {
+            if (row[static_cast<size_t>(i)] <= 0.0f)
+                continue;
+
+            bool taken = false;
+            for (int c = 0; c < numCandidates; ++c)
+                taken = taken || candidates[static_cast<size_t>(c)] == shapes[static_cast<size_t>(i)];
+
+            if (!taken && (best < 0 || row[static_cast<size_t>(i)] > row[static_cast<size_t>(best)]))
+                best = i;
+        }
+
+        if (best < 0)
+            break;
+
+        addCandidate(shapes[static_cast<size_t>(best)]);
+    }
+
+    addCandidate(chord.heldNotes.transposed(5));
+    addCandidate(chord.heldNotes.transposed(7));
+    addCandidate(chord.heldNotes.transposed(-5));
+
+    // Voice every candidate from the voicing that is sounding now
+    const int numReference = juce::jmin(static_cast<int>(chord.numNotes), MAX_NOTES);
+    juce::Array<int> reference;
+    for (int i = 0; i < numReference; ++i)
+        reference.add(chord.notes[i]);
+
+    auto& zonePredictions = latest.predictions[chord.zone];
+
+    for (int c = 0; c < PREDICTIONS_PER_ZONE; ++c)
+    {
+        auto& prediction = zonePredictions[static_cast<size_t>(c)];
+        prediction = VoicedChord();
+
+        if (c >= numCandidates)
+            continue;
+
+        const auto& candidate = candidates[static_cast<size_t>(c)];
+
+        juce::Array<int> heldNotes;
+        for (int note = 0; note < 128; ++note)
+            if ((candidate.bits[note >> 6] & (uint64_t(1) << (note & 63))) != 0)
+                heldNotes.add(note);
+
+        const auto voicing = voiceChord(heldNotes, chord.density, *chord.style, chord.scaleMask, reference);
+        if (voicing.isEmpty() || voicing.size() > MAX_NOTES)
+            continue;
+
+        prediction.heldNotes = candidate;
+        prediction.style = chord.style;
+        prediction.density = chord.density;
+        prediction.scaleMask = chord.scaleMask;
+        prediction.zone = chord.zone;
+        prediction.numReference = static_cast<uint8_t>(numReference);
+        std::copy_n(chord.notes, numReference, prediction.reference);
+        prediction.numNotes = static_cast<uint8_t>(voicing.size());
+        for (int i = 0; i < voicing.size(); ++i)
+            prediction.notes[i] = static_cast<uint8_t>(voicing.getUnchecked(i));
+    }
+}
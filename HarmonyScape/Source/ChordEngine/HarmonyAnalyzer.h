@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "../TripleBuffer.h"
+#include "VoicingStyles.h"
+#include "VoiceLeading.h"
+#include <array>
+
+/**
+ * HarmonyAnalyzer runs harmony analysis that is too heavy for processBlock on a
+ * dedicated worker thread.
+ *
+ * The audio thread reports each chord the player strikes through a lock-free SPSC
+ * queue (juce::AbstractFifo), which the worker polls, so reporting never takes a
+ * lock or wakes a thread. The worker learns a Markov model of chord-shape
+ * transitions, predicts the most likely next shapes (falling back to moves by a
+ * fourth and a fifth while there is no history) and fully voices them, including
+ * voice leading from the chord just played. Predictions are published through a
+ * TripleBuffer, so when a predicted chord arrives the audio thread only performs
+ * a lookup.
+ *
+ * A prediction is only used if everything the voicing depends on matches exactly
+ * (held notes, density level, style, key and the reference voicing), so a hit
+ * gives the same notes the audio thread would have computed.
+ */
+class HarmonyAnalyzer : private juce::Thread
+{
+public:
+    static constexpr int MAX_ZONES = 16;                 // Matches ChordEngine::MAX_ZONES
+    static constexpr int PREDICTIONS_PER_ZONE = 4;
+    static constexpr int MAX_NOTES = VoiceLeadingOptimizer::MAX_VOICES;
+
+    /**
+     * Held keys as a 128-bit set, the identity of a chord shape
+     */
+    struct NoteMask
+    {
+        uint64_t bits[2] {};
+
+        void add(int noteNumber) { bits[noteNumber >> 6] |= uint64_t(1) << (noteNumber & 63); }
+        bool contains(int noteNumber) const { return (bits[noteNumber >> 6] & (uint64_t(1) << (noteNumber & 63))) != 0; }
+        bool isEmpty() const { return bits[0] == 0 && bits[1] == 0; }
+        bool operator== (const NoteMask& other) const { return bits[0] == other.bits[0] && bits[1] == other.bits[1]; }
+        bool operator!= (const NoteMask& other) const { return !(*this == other); }
+        NoteMask transposed(int semitones) const;
+    };
+
+    /**
+     * A chord as voiced on the audio thread, or as predicted by the worker.
+     * Plain data so it can travel through the queue and the snapshot.
+     */
+    struct VoicedChord
+    {
+        NoteMask heldNotes;
+        const CompiledVoicingStyle* style = nullptr;
+        float density = 0.0f;
+        uint16_t scaleMask = 0;
+        uint8_t zone = 0;
+        uint8_t numReference = 0;
+        uint8_t numNotes = 0;
+        uint8_t reference[MAX_NOTES] {};     // Voicing the chord was voice-led from
+        uint8_t notes[MAX_NOTES] {};         // Resulting voicing
+    };
+
+    /**
+     * Published predictions for every zone
+     */
+    struct Snapshot
+    {
+        std::array<std::array<VoicedChord, PREDICTIONS_PER_ZONE>, MAX_ZONES> predictions {};
+
+        /**
+         * Finds a prediction matching every input of the voicing.
+         * @return The prediction, or nullptr
+         */
+        const VoicedChord* find(int zone, const NoteMask& heldNotes, int densityLevel,
+                                const CompiledVoicingStyle* style, uint16_t scaleMask,
+                                const juce::Array<int>& reference) const;
+    };
+
+    /**
+     * Voices a chord shape from scratch: detection, voicing and voice leading.
+     * Supplied by ChordEngine so predictions use exactly the audio thread's rules.
+     */
+    using VoicingFunction = std::function<juce::Array<int>(const juce::Array<int>& heldNotes, float density,
+                                                           const CompiledVoicingStyle& style, uint16_t scaleMask,
+                                                           const juce::Array<int>& reference)>;
+
+    explicit HarmonyAnalyzer(VoicingFunction voicingFunction);
+    ~HarmonyAnalyzer() override;
+
+    /** Starts the worker if it isn't running. */
+    void start();
+
+    /**
+     * Audio thread: reports a voiced chord. Lock-free; the worker picks it up on
+     * its next poll. The event is dropped if the queue is full.
+     */
+    void pushChord(const VoicedChord& chord);
+
+    /** Audio thread: the latest predictions (single reader). */
+    const Snapshot& readPredictions() { return snapshots.read(); }
+
+private:
+    void run() override;
+    void analyse(const VoicedChord& chord);
+
+    // Index of a shape in the transition table, adding (or recycling) a slot if needed
+    int findOrAddShape(const NoteMask& shape);
+
+    VoicingFunction voiceChord;
+
+    // Audio thread -> worker, polled at this interval
+    static constexpr int QUEUE_SIZE = 256;
+    static constexpr int POLL_INTERVAL_MS = 5;
+    juce::AbstractFifo queueFifo { QUEUE_SIZE };
+    std::array<VoicedChord, QUEUE_SIZE> queue;
+
+    // Worker -> audio thread
+    TripleBuffer<Snapshot> snapshots;
+    Snapshot latest;
+
+    // Markov model over chord shapes (worker thread only)
+    static constexpr int MAX_SHAPES = 128;
+    std::array<NoteMask, MAX_SHAPES> shapes {};
+    std::array<uint32_t, MAX_SHAPES> shapeLastUsed {};
+    std::array<std::array<float, MAX_SHAPES>, MAX_SHAPES> transitions {};
+    std::array<int, MAX_ZONES> previousShape;
+    int numShapes = 0;
+    uint32_t eventCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (HarmonyAnalyzer)
+};
@@ -0,0 +1,114 @@
+#include "KeyTracker.h"
+
+// Krumhansl-Kessler probe-tone profiles, rotated to every tonic and mean-centred
+const std::array<std::array<float, 12>, KeyTracker::NUM_KEYS> KeyTracker::profiles = []
+{
+    static constexpr float major[12] = { 6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f };
+    static constexpr float minor[12] = { 6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f };
+
+    std::array<std::array<float, 12>, NUM_KEYS> table {};
+
+    for (int key = 0; key < NUM_KEYS; ++key)
+    {
+        const float* profile = key < 12 ? major : minor;
+        const int tonic = key % 12;
+
+        float mean = 0.0f;
+        for (int i = 0; i < 12; ++i)
+            mean += profile[i];
+        mean /= 12.0f;
+
+        for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+            table[static_cast<size_t>(key)][static_cast<size_t>(pitchClass)] = profile[(pitchClass - tonic + 12) % 12] - mean;
+    }
+
+    return table;
+}();
+
+KeyTracker::KeyTracker()
+{
+    reset();
+}
+
+void KeyTracker::reset()
+{
+    scores.fill(0.0f);
+    totalWeight = 0.0f;
+    bestKey = 0;
+    runnerUpKey = 1;
+}
+
+void KeyTracker::noteOn(int noteNumber, float velocity)
+{
+    const int pitchClass = ((noteNumber % 12) + 12) % 12;
+    const float weight = juce::jlimit(0.1f, 1.0f, velocity);
+
+    // Decaying the histogram scales every dot product by the same factor
+    totalWeight = totalWeight * decayPerNote + weight;
+
+    for (int key = 0; key < NUM_KEYS; ++key)
+    {
+        auto& score = scores[static_cast<size_t>(key)];
+        score = score * decayPerNote + weight * profiles[static_cast<size_t>(key)][static_cast<size_t>(pitchClass)];
+    }
+
+    // Track the leader and runner-up for the confidence margin
+    bestKey = scores[1] > scores[0] ? 1 : 0;
+    runnerUpKey = 1 - bestKey;
+
+    for (int key = 2; key < NUM_KEYS; ++key)
+    {
+        const float score = scores[static_cast<size_t>(key)];
+
+        if (score > scores[static_cast<size_t>(bestKey)])
+        {
+            runnerUpKey = bestKey;
+            bestKey = key;
+        }
+        else if (score > scores[static_cast<size_t>(runnerUpKey)])
+        {
+            runnerUpKey = key;
+        }
+    }
+}
+
+bool KeyTracker::hasEstimate() const
+{
+    if (totalWeight < minimumWeight)
+        return false;
+
+    const float best = scores[static_cast<size_t>(bestKey)];
+    const float runnerUp = scores[static_cast<size_t>(runnerUpKey)];
+
+    if (best <= 0.0f)
+        return false;
+
+    // A relative major/minor runner-up shares the scale, so it doesn't make the estimate ambiguous
+    if (getScaleMaskForKey(runnerUpKey) == getScaleMaskForKey(bestKey))
+        return true;
+
+    return best - runnerUp >= minimumMargin * best;
+}
+
+uint16_t KeyTracker::getScaleMask() const
+{
+    return hasEstimate() ? getScaleMaskForKey(bestKey) : 0;
+}
+
+uint16_t KeyTracker::getScaleMaskForKey(int key)
+{
+    static constexpr uint16_t majorScale = 0b101010110101;   // 0 2 4 5 7 9 11
+    static constexpr uint16_t minorScale = 0b010110101101;   // 0 2 3 5 7 8 10
+
+    const uint16_t scale = key >= 12 ? minorScale : majorScale;
+    const int tonic = key % 12;
+
+    // Rotate the scale up to the tonic
+    return static_cast<uint16_t>(((scale << tonic) | (scale >> (12 - tonic))) & 0xfff);
+}
+
+juce::String KeyTracker::getKeyName() const
+{
+    static const juce::String noteNames[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    return noteNames[getTonic()] + (isMinor() ? " minor" : " major");
+}
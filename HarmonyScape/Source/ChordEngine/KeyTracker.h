@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include <array>
+
+/**
+ * KeyTracker estimates the current key from the incoming note stream.
+ *
+ * Note-ons feed a pitch-class histogram that decays per note event, so recent
+ * playing dominates. The histogram is correlated against the 24 Krumhansl-Kessler
+ * key profiles (12 major, 12 minor). Because the profiles are mean-centred, the
+ * dot product ranks keys like a correlation, and it is linear in the histogram:
+ * each key's score is updated in place per note (24 multiplies and 24
+ * multiply-adds) instead of being recomputed from the whole histogram.
+ *
+ * Nothing runs per block and nothing allocates.
+ */
+class KeyTracker
+{
+public:
+    static constexpr int NUM_KEYS = 24;     // 0-11 major on C..B, 12-23 minor on C..B
+
+    KeyTracker();
+
+    /** Clears the histogram and the estimate. */
+    void reset();
+
+    /**
+     * Feeds a note-on into the histogram and updates every key score.
+     * @param noteNumber MIDI note number
+     * @param velocity Note-on velocity (0.0-1.0), used as the weight
+     */
+    void noteOn(int noteNumber, float velocity);
+
+    /** True once enough notes have been heard and one key clearly leads. */
+    bool hasEstimate() const;
+
+    /** Index of the best matching key (see NUM_KEYS). */
+    int getKey() const { return bestKey; }
+
+    /** Pitch class of the best key's tonic (0 = C). */
+    int getTonic() const { return bestKey % 12; }
+
+    /** True if the best key is minor. */
+    bool isMinor() const { return bestKey >= 12; }
+
+    /**
+     * 12-bit mask of the best key's scale (bit n = pitch class n), or 0 while
+     * there is no estimate. Minor keys use the natural minor scale.
+     */
+    uint16_t getScaleMask() const;
+
+    /** Key name, e.g. "A minor". */
+    juce::String getKeyName() const;
+
+private:
+    // Histogram weight kept per note event (half-life of about 14 notes)
+    static constexpr float decayPerNote = 0.95f;
+
+    // Minimum decayed histogram mass before the estimate is trusted
+    static constexpr float minimumWeight = 2.5f;
+
+    // Lead of the best key over the runner-up, relative to the best score
+    static constexpr float minimumMargin = 0.02f;
+
+    // Scale mask of any key index
+    static uint16_t getScaleMaskForKey(int key);
+
+    // Mean-centred profiles for every key, indexed [key][pitch class]
+    static const std::array<std::array<float, 12>, NUM_KEYS> profiles;
+
+    std::array<float, NUM_KEYS> scores {};
+    float totalWeight = 0.0f;
+    int bestKey = 0;
+    int runnerUpKey = 1;
+};
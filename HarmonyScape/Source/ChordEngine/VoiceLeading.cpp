@@ -0,0 +1,171 @@
+#include "VoiceLeading.h"
+
+// Interval cost table: steps are cheap, leaps beyond a fifth get progressively dearer
+const std::array<int, 128> VoiceLeadingOptimizer::intervalCosts = []
+{
+    std::array<int, 128> costs {};
+    for (int interval = 0; interval < 128; ++interval)
+    {
+        int cost = interval * 4;
+        if (interval > 7)
+            cost += (interval - 7) * 2;
+        costs[static_cast<size_t>(interval)] = cost;
+    }
+    return costs;
+}();
+
+int VoiceLeadingOptimizer::computeAssignmentCost(const int* fromNotes, int numFrom,
+                                                 const int* toNotes, int numTo) const
+{
+    const int numSlots = juce::jmax(numFrom, numTo);
+    jassert(numSlots <= MAX_VOICES);
+
+    if (numSlots == 0)
+        return 0;
+
+    // Pairwise cost matrix; slots beyond either voicing are "no voice"
+    int costMatrix[MAX_VOICES][MAX_VOICES];
+    for (int i = 0; i < numSlots; ++i)
+    {
+        for (int j = 0; j < numSlots; ++j)
+        {
+            if (i < numFrom && j < numTo)
+            {
+                const int interval = std::abs(fromNotes[i] - toNotes[j]);
+                costMatrix[i][j] = intervalCosts[static_cast<size_t>(juce::jmin(interval, 127))]
+                                 + (interval != 0 ? changedNotePenalty : 0);
+            }
+            else if (i < numFrom || j < numTo)
+            {
+                costMatrix[i][j] = addOrRemovePenalty;
+            }
+            else
+            {
+                costMatrix[i][j] = 0;
+            }
+        }
+    }
+
+    // Exact assignment by DP over subsets: dp[mask] is the cheapest way of giving
+    // the first popcount(mask) source voices the destination voices in mask
+    constexpr int maxStates = 1 << MAX_VOICES;
+    constexpr int unreachable = std::numeric_limits<int>::max() / 2;
+
+    std::array<int, maxStates> dp;
+    const int numStates = 1 << numSlots;
+    std::fill(dp.begin(), dp.begin() + numStates, unreachable);
+    dp[0] = 0;
+
+    for (int mask = 0; mask < numStates; ++mask)
+    {
+        if (dp[static_cast<size_t>(mask)] >= unreachable)
+            continue;
+
+        const int source = juce::countNumberOfBits(static_cast<uint32_t>(mask));
+        if (source >= numSlots)
+            continue;
+
+        for (int destination = 0; destination < numSlots; ++destination)
+        {
+            if ((mask & (1 << destination)) != 0)
+                continue;
+
+            const int nextMask = mask | (1 << destination);
+            const int cost = dp[static_cast<size_t>(mask)] + costMatrix[source][destination];
+            if (cost < dp[static_cast<size_t>(nextMask)])
+                dp[static_cast<size_t>(nextMask)] = cost;
+        }
+    }
+
+    return dp[static_cast<size_t>(numStates - 1)];
+}
+
+void VoiceLeadingOptimizer::sortNotes(std::array<int, MAX_VOICES>& notes, int numNotes)
+{
+    for (int i = 1; i < juce::jmin(numNotes, MAX_VOICES); ++i)
+    {
+        const int note = notes[static_cast<size_t>(i)];
+        int j = i;
+        for (; j > 0 && notes[static_cast<size_t>(j - 1)] > note; --j)
+            notes[static_cast<size_t>(j)] = notes[static_cast<size_t>(j - 1)];
+        notes[static_cast<size_t>(j)] = note;
+    }
+}
+
+void VoiceLeadingOptimizer::findBestVoicing(const juce::Array<int>& previous, juce::Array<int>& candidate) const
+{
+    const int numPrevious = previous.size();
+    const int numCandidate = candidate.size();
+
+    if (numPrevious == 0 || numCandidate == 0
+        || numPrevious > MAX_VOICES || numCandidate > MAX_VOICES)
+        return;
+
+    std::array<int, MAX_VOICES> previousNotes {};
+    std::array<int, MAX_VOICES> sortedCandidate {};
+    std::copy(previous.begin(), previous.end(), previousNotes.begin());
+    std::copy(candidate.begin(), candidate.end(), sortedCandidate.begin());
+    sortNotes(sortedCandidate, numCandidate);
+
+    int candidateSum = 0;
+    for (int i = 0; i < numCandidate; ++i)
+        candidateSum += sortedCandidate[static_cast<size_t>(i)];
+
+    std::array<int, MAX_VOICES> bestPlacement = sortedCandidate;
+    int bestCost = std::numeric_limits<int>::max();
+
+    // Octave 0 / inversion 0 is tried first so that ties keep the voicing as generated
+    static constexpr int octaveShifts[] = { 0, -12, 12 };
+
+    for (int octaveShift : octaveShifts)
+    {
+        for (int inversion = 0; inversion < numCandidate; ++inversion)
+        {
+            // Rotate the lowest notes up an octave to form the inversion
+            std::array<int, MAX_VOICES> placement {};
+            bool inRange = true;
+
+            for (int i = 0; i < numCandidate; ++i)
+            {
+                int note = sortedCandidate[static_cast<size_t>(i)] + octaveShift;
+                if (i < inversion)
+                    note += 12;
+
+                if (note < LOWEST_NOTE || note > HIGHEST_NOTE)
+                {
+                    inRange = false;
+                    break;
+                }
+
+                placement[static_cast<size_t>(i)] = note;
+            }
+
+            if (!inRange)
+                continue;
+
+            // Inversions of voicings with octave doublings can collapse two voices
+            sortNotes(placement, numCandidate);
+            if (std::adjacent_find(placement.begin(), placement.begin() + numCandidate) != placement.begin() + numCandidate)
+                continue;
+
+            int cost = computeAssignmentCost(previousNotes.data(), numPrevious,
+                                             placement.data(), numCandidate);
+
+            // Mild pull back towards the generated register so repeated changes don't drift
+            int placementSum = 0;
+            for (int i = 0; i < numCandidate; ++i)
+                placementSum += placement[static_cast<size_t>(i)];
+            cost += std::abs(placementSum - candidateSum) / numCandidate;
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestPlacement = placement;
+            }
+        }
+    }
+
+    // Same number of notes, so the candidate's storage is reused
+    for (int i = 0; i < numCandidate; ++i)
+        candidate.setUnchecked(i, bestPlacement[static_cast<size_t>(i)]);
+}
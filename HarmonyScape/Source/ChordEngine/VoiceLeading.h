@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include <array>
+
+/**
+ * VoiceLeadingOptimizer connects consecutive chord voicings smoothly.
+ *
+ * Given the previously sounding voicing and a freshly generated candidate, it
+ * tries every inversion and octave placement of the candidate and solves the
+ * voice assignment between old and new notes exactly. The placement with the
+ * lowest total cost (semitone movement plus a penalty per changed note) wins.
+ *
+ * All work is bounded: at most MAX_VOICES voices, MAX_VOICES inversions and
+ * three octave shifts, and the assignment is a DP over subsets of at most
+ * 2^MAX_VOICES states. The voicing is re-voiced in place in the caller's array,
+ * so as long as that array has room for the candidate (ChordEngine reserves it
+ * in prepare), nothing here allocates.
+ */
+class VoiceLeadingOptimizer
+{
+public:
+    // Maximum number of voices considered on either side of the assignment
+    static constexpr int MAX_VOICES = 8;
+
+    // Lowest and highest MIDI notes a placement may use (matches generateVoicing)
+    static constexpr int LOWEST_NOTE = 36;
+    static constexpr int HIGHEST_NOTE = 108;
+
+    VoiceLeadingOptimizer() = default;
+
+    /**
+     * Chooses the inversion and octave placement of a candidate voicing that
+     * moves the least from the previous voicing.
+     * @param previous Notes of the voicing that is currently (or was last) sounding
+     * @param candidate Notes of the newly generated voicing, replaced by the re-voiced
+     *        candidate sorted ascending. Left unchanged if previous is empty or
+     *        either side exceeds MAX_VOICES.
+     */
+    void findBestVoicing(const juce::Array<int>& previous, juce::Array<int>& candidate) const;
+
+    /**
+     * Computes the minimum assignment cost between two voicings.
+     * Voices without a partner are charged as an added or released note.
+     */
+    int computeAssignmentCost(const int* fromNotes, int numFrom,
+                              const int* toNotes, int numTo) const;
+
+private:
+    // Sorts the first numNotes entries ascending (insertion sort; at most MAX_VOICES notes)
+    static void sortNotes(std::array<int, MAX_VOICES>& notes, int numNotes);
+
+    // Cost units per semitone of movement, indexed by absolute interval (0-127)
+    static const std::array<int, 128> intervalCosts;
+
+    // Extra cost for any voice that has to change note (retrigger downstream)
+    static constexpr int changedNotePenalty = 6;
+
+    // Cost for a voice that appears or disappears between voicings
+    static constexpr int addOrRemovePenalty = 24;
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "ChordTypes.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A single precomputed voicing: note offsets in semitones relative to the chord root.
+ * Packed into 8 bytes so the whole dictionary stays a few kilobytes of read-only data.
+ */
+struct VoicingCandidate
+{
+    static constexpr int MAX_NOTES = 6;
+
+    int8_t offsets[MAX_NOTES] {};   // Semitones above (or below) the root, ascending
+    uint8_t numNotes = 0;           // 0 marks an unused slot
+    uint8_t score = 255;            // Static consonance/spread cost, lower is better
+};
+
+/**
+ * Generates the voicing dictionary at compile time.
+ *
+ * For every chord quality a pool of chord tones and tensions is combined into
+ * every subset and placed with several spread styles (close, open, bass-anchored,
+ * upper structure). Each placement is scored with a roughness table indexed by
+ * interval and a register-spread table per density level, and the best
+ * CANDIDATES_PER_ENTRY placements per (quality, density level) are kept sorted.
+ */
+struct VoicingDictionaryBuilder
+{
+    static constexpr int CANDIDATES_PER_ENTRY = 12;
+    static constexpr int NUM_ENTRIES = NUM_CHORD_QUALITIES * NUM_DENSITY_LEVELS;
+    static constexpr int NUM_SPREAD_STYLES = 4;
+    static constexpr int MAX_POOL_TONES = 6;
+
+    using Table = std::array<VoicingCandidate, NUM_ENTRIES * CANDIDATES_PER_ENTRY>;
+
+    // Pitch classes available to each quality; the first numCore are chord tones.
+    // Tones in requiredTones (a mask of pool indices) are kept in every voicing.
+    struct TonePool
+    {
+        int8_t tones[MAX_POOL_TONES];
+        int numTones;
+        int numCore;
+        int requiredTones = 0;
+    };
+
+    static constexpr TonePool getTonePool(ChordQuality quality)
+    {
+        switch (quality)
+        {
+            case ChordQuality::Single:      return { { 7, 0, 2, 5, 9, 0 }, 5, 1 };   // Fifth, then sus/6-9 colours
+            case ChordQuality::Major:       return { { 4, 7, 0, 11, 2, 6 }, 6, 2 };  // maj9#11
+            case ChordQuality::Minor:       return { { 3, 7, 0, 10, 2, 5 }, 6, 2 };  // m11
+            case ChordQuality::Dominant7:   return { { 4, 10, 7, 0, 2, 9 }, 6, 2 };  // 9/13
+            case ChordQuality::Major7:      return { { 4, 11, 7, 0, 2, 6 }, 6, 2 };  // maj9#11
+            case ChordQuality::Minor7:      return { { 3, 10, 7, 0, 2, 5 }, 6, 2 };  // m11
+            case ChordQuality::Diminished:  return { { 3, 6, 0, 9, 2, 5 }, 6, 2, 1 << 1 };  // Always the b5
+            case ChordQuality::Diminished7: return { { 3, 6, 9, 0, 2, 5 }, 6, 3, 1 << 1 };
+            case ChordQuality::Augmented:   return { { 4, 8, 0, 2, 6, 10 }, 6, 2 };
+            case ChordQuality::Sus4:        return { { 5, 7, 0, 10, 2, 9 }, 6, 2 };
+            case ChordQuality::Unknown:
+            case ChordQuality::NumQualities:
+            default:                        return { { 7, 0, 2, 0, 0, 0 }, 3, 1 };
+        }
+    }
+
+    // Roughness of an interval in semitones (0-47), lower is more consonant
+    static constexpr int getRoughness(int interval)
+    {
+        constexpr int withinOctave[12] = { 20, 10, 5, 2, 1, 1, 4, 0, 2, 1, 3, 7 };
+
+        if (interval < 0)
+            interval = -interval;
+        if (interval == 0)
+            return withinOctave[0];
+
+        const int pitchClass = interval % 12;
+        int roughness = withinOctave[pitchClass];
+
+        // Compound intervals are smoother, except the minor ninth which stays harsh
+        if (interval > 12 && pitchClass != 1)
+            roughness /= 2;
+        else if (interval > 12)
+            roughness = 8;
+
+        return roughness;
+    }
+
+    // Register spread table per density level: { minNotes, maxNotes, idealSpan, richnessBonus }
+    struct SpreadRule
+    {
+        int minNotes;
+        int maxNotes;
+        int idealSpan;
+        int richnessBonus;
+    };
+
+    static constexpr SpreadRule getSpreadRule(int densityLevel)
+    {
+        switch (densityLevel)
+        {
+            case 0:  return { 1, 2, 24, 2 };
+            case 1:  return { 2, 4, 19, 6 };
+            default: return { 3, 6, 26, 10 };
+        }
+    }
+
+    // Place a pool tone according to a spread style, returning the offset from the root
+    static constexpr int placeTone(int pitchClass, bool isCore, int spreadStyle)
+    {
+        switch (spreadStyle)
+        {
+            case 0:  // Close: everything within the octave above the root
+                return pitchClass == 0 ? 12 : pitchClass;
+            case 1:  // Open: chord tones close, tensions an octave up
+                return pitchClass == 0 ? 12 : (isCore ? pitchClass : pitchClass + 12);
+            case 2:  // Bass-anchored: root doubled below, tensions on top
+                return pitchClass == 0 ? -12 : (isCore ? pitchClass : pitchClass + 12);
+            default: // Upper structure: everything up an octave, root sparkle two octaves up
+                return pitchClass == 0 ? 24 : pitchClass + 12;
+        }
+    }
+
+    static constexpr Table build()
+    {
+        Table table {};
+
+        for (int quality = 0; quality < NUM_CHORD_QUALITIES; ++quality)
+        {
+            const auto pool = getTonePool(static_cast<ChordQuality>(quality));
+
+            for (int level = 0; level < NUM_DENSITY_LEVELS; ++level)
+            {
+                const auto rule = getSpreadRule(level);
+                const int base = (quality * NUM_DENSITY_LEVELS + level) * CANDIDATES_PER_ENTRY;
+
+                for (int mask = 1; mask < (1 << pool.numTones); ++mask)
+                {
+                    if ((mask & pool.requiredTones) != pool.requiredTones)
+                        continue;
+
+                    for (int style = 0; style < NUM_SPREAD_STYLES; ++style)
+                    {
+                        VoicingCandidate candidate {};
+                        int count = 0;
+
+                        for (int tone = 0; tone < pool.numTones; ++tone)
+                        {
+                            if ((mask & (1 << tone)) != 0 && count < VoicingCandidate::MAX_NOTES)
+                            {
+                                candidate.offsets[count++] = static_cast<int8_t>(
+                                    placeTone(pool.tones[tone], tone < pool.numCore, style));
+                            }
+                        }
+
+                        if (count < rule.minNotes || count > rule.maxNotes)
+                            continue;
+
+                        // Insertion sort the offsets and reject duplicates
+                        bool duplicate = false;
+                        for (int i = 1; i < count; ++i)
+                        {
+                            const int8_t value = candidate.offsets[i];
+                            int j = i - 1;
+                            while (j >= 0 && candidate.offsets[j] > value)
+                            {
+                                candidate.offsets[j + 1] = candidate.offsets[j];
+                                --j;
+                            }
+                            candidate.offsets[j + 1] = value;
+                        }
+                        for (int i = 1; i < count; ++i)
+                            if (candidate.offsets[i] == candidate.offsets[i - 1])
+                                duplicate = true;
+
+                        if (duplicate)
+                            continue;
+
+                        candidate.numNotes = static_cast<uint8_t>(count);
+
+                        // Roughness over every pair, including against the played root
+                        int cost = 0;
+                        for (int i = 0; i < count; ++i)
+                        {
+                            cost += getRoughness(candidate.offsets[i]);
+                            for (int j = i + 1; j < count; ++j)
+                                cost += getRoughness(candidate.offsets[j] - candidate.offsets[i]);
+                        }
+
+                        // Register spread relative to the ideal span for this density
+                        const int low = candidate.offsets[0] < 0 ? candidate.offsets[0] : 0;
+                        const int span = candidate.offsets[count - 1] - low;
+                        cost += (span > rule.idealSpan ? span - rule.idealSpan : rule.idealSpan - span) / 2;
+
+                        // Richer densities reward more notes
+                        cost += 64 - rule.richnessBonus * count;
+
+                        candidate.score = static_cast<uint8_t>(cost < 0 ? 0 : (cost > 254 ? 254 : cost));
+
+                        // Different masks and styles can produce the same placement
+                        bool alreadyListed = false;
+                        for (int i = 0; i < CANDIDATES_PER_ENTRY && !alreadyListed; ++i)
+                        {
+                            const auto& existing = table[static_cast<std::size_t>(base + i)];
+                            if (existing.numNotes != candidate.numNotes)
+                                continue;
+
+                            bool same = true;
+                            for (int n = 0; n < count; ++n)
+                                same = same && existing.offsets[n] == candidate.offsets[n];
+                            alreadyListed = same;
+                        }
+
+                        if (alreadyListed)
+                            continue;
+
+                        // Keep the best candidates sorted by score
+                        int position = CANDIDATES_PER_ENTRY;
+                        while (position > 0
+                               && (table[static_cast<std::size_t>(base + position - 1)].numNotes == 0
+                                   || table[static_cast<std::size_t>(base + position - 1)].score > candidate.score))
+                            --position;
+
+                        if (position >= CANDIDATES_PER_ENTRY)
+                            continue;
+
+                        for (int i = CANDIDATES_PER_ENTRY - 1; i > position; --i)
+                            table[static_cast<std::size_t>(base + i)] = table[static_cast<std::size_t>(base + i - 1)];
+
+                        table[static_cast<std::size_t>(base + position)] = candidate;
+                    }
+                }
+            }
+        }
+
+        return table;
+    }
+};
+
+/**
+ * VoicingDictionary gives the audio thread read-only access to the precomputed
+ * voicing candidates. The table is generated once at build time and embedded as
+ * constant data; lookups are a single index computation.
+ */
+class VoicingDictionary
+{
+public:
+    static constexpr int CANDIDATES_PER_ENTRY = VoicingDictionaryBuilder::CANDIDATES_PER_ENTRY;
+
+    /**
+     * Returns the ranked candidates for a chord quality and density level.
+     * The pointer addresses CANDIDATES_PER_ENTRY entries; unused slots have numNotes == 0.
+     */
+    static const VoicingCandidate* getCandidates(ChordQuality quality, int densityLevel)
+    {
+        const int q = static_cast<int>(quality) < NUM_CHORD_QUALITIES ? static_cast<int>(quality)
+                                                                      : static_cast<int>(ChordQuality::Unknown);
+        const int level = densityLevel < 0 ? 0 : (densityLevel >= NUM_DENSITY_LEVELS ? NUM_DENSITY_LEVELS - 1 : densityLevel);
+        return &table[static_cast<std::size_t>((q * NUM_DENSITY_LEVELS + level) * CANDIDATES_PER_ENTRY)];
+    }
+
+    /** Raw access to the embedded dictionary blob (e.g. for inspection or export). */
+    static const void* getData() { return table.data(); }
+    static std::size_t getSizeInBytes() { return sizeof(table); }
+
+    static constexpr VoicingDictionaryBuilder::Table table = VoicingDictionaryBuilder::build();
+};
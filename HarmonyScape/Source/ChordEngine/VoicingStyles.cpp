@@ -0,0 +1,133 @@
+#include "VoicingStyles.h"
+
+VoicingStyleLibrary::VoicingStyleLibrary()
+    : activeStyle(&FactoryVoicingStyles::compiled[0])
+{
+}
+
+VoicingStyleLibrary::~VoicingStyleLibrary()
+{
+    // Let any pending compile finish before the tables it publishes into go away
+    loader->removeJobs(this);
+}
+
+void VoicingStyleLibrary::selectFactoryStyle(int index) noexcept
+{
+    index = juce::jlimit(0, FactoryVoicingStyles::NUM_STYLES - 1, index);
+    selectedFactoryStyle.store(index);
+    activeStyle.store(&FactoryVoicingStyles::compiled[static_cast<size_t>(index)], std::memory_order_release);
+}
+
+bool VoicingStyleLibrary::loadUserStylesAsync(const juce::File& directory)
+{
+    if (!directory.isDirectory())
+        return false;
+
+    loader->addJob(this, [this, directory]
+    {
+        auto files = directory.findChildFiles(juce::File::findFiles, false, "*.json");
+        files.sort();
+
+        // A reload starts from empty slots; styles compiled earlier stay alive in userStyles
+        numUserStyles.store(0);
+        for (auto& slot : userStyleSlots)
+            slot.store(nullptr, std::memory_order_release);
+
+        // Each file keeps the slot of its place in name order, so one that fails to
+        // parse leaves its slot empty instead of shifting every later style down
+        const int numFiles = juce::jmin(files.size(), MAX_USER_STYLES);
+        for (int index = 0; index < numFiles; ++index)
+        {
+            juce::String id, name;
+            VoicingStyleTemplate style;
+            if (parseStyleTemplate(juce::JSON::parse(files.getReference(index)), style, id, name))
+            {
+                auto compiled = std::make_unique<CompiledVoicingStyle>(VoicingStyleCompiler::compile(style));
+                const CompiledVoicingStyle* published = compiled.get();
+
+                {
+                    const juce::ScopedLock lock(userStylesLock);
+                    userStyles.add(compiled.release());
+                }
+
+                userStyleSlots[static_cast<size_t>(index)].store(published, std::memory_order_release);
+            }
+
+            numUserStyles.store(index + 1);
+        }
+    });
+
+    return true;
+}
+
+juce::File VoicingStyleLibrary::getUserStyleDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile(JucePlugin_Name)
+               .getChildFile("Styles");
+}
+
+juce::String VoicingStyleLibrary::getUserStyleName(int index) const
+{
+    if (juce::isPositiveAndBelow(index, getNumUserStyles()))
+        if (const auto* style = userStyleSlots[static_cast<size_t>(index)].load(std::memory_order_acquire))
+            return style->name;
+
+    return {};
+}
+
+bool VoicingStyleLibrary::selectUserStyle(int index) noexcept
+{
+    if (!juce::isPositiveAndBelow(index, MAX_USER_STYLES))
+        return false;
+
+    const auto* style = userStyleSlots[static_cast<size_t>(index)].load(std::memory_order_acquire);
+    if (style == nullptr)
+        return false;
+
+    selectedFactoryStyle.store(-1);
+    activeStyle.store(style, std::memory_order_release);
+    return true;
+}
+
+bool VoicingStyleLibrary::parseStyleTemplate(const juce::var& json, VoicingStyleTemplate& style,
+                                             juce::String& idStorage, juce::String& nameStorage)
+{
+    if (!json.isObject())
+        return false;
+
+    // Arrays of semitones (mod 12) become bit masks
+    auto toMask = [](const juce::var& values)
+    {
+        uint16_t mask = 0;
+        if (auto* array = values.getArray())
+            for (const auto& value : *array)
+                mask = static_cast<uint16_t>(mask | (1 << ((static_cast<int>(value) % 12 + 12) % 12)));
+        return mask;
+    };
+
+    idStorage = json.getProperty("id", "user").toString();
+    nameStorage = json.getProperty("name", idStorage).toString();
+    style.id = idStorage.toRawUTF8();
+    style.name = nameStorage.toRawUTF8();
+
+    style.defaultDensity = juce::jlimit(0.0f, 1.0f, static_cast<float>(json.getProperty("defaultDensity", 0.5)));
+    style.preferredExtensions = toMask(json.getProperty("preferredExtensions", {}));
+    style.avoidedExtensions = toMask(json.getProperty("avoidedExtensions", {}));
+    style.rootBassFrequency = juce::jlimit(0.0f, 1.0f, static_cast<float>(json.getProperty("rootBassFrequency", 0.5)));
+
+    if (auto* range = json.getProperty("voiceCountRange", {}).getArray())
+    {
+        if (range->size() == 2)
+        {
+            style.minVoices = juce::jlimit(1, VoicingCandidate::MAX_NOTES, static_cast<int>((*range)[0]));
+            style.maxVoices = juce::jlimit(style.minVoices, VoicingCandidate::MAX_NOTES, static_cast<int>((*range)[1]));
+        }
+    }
+
+    const auto intervals = json.getProperty("intervalPreferences", {});
+    style.preferredIntervals = toMask(intervals.getProperty("preferred", {}));
+    style.avoidedIntervals = toMask(intervals.getProperty("avoided", {}));
+
+    return true;
+}
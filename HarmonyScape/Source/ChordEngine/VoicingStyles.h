@@ -0,0 +1,270 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "../BackgroundLoader.h"
+#include "ChordTypes.h"
+#include "VoicingDictionary.h"
+#include <array>
+#include <atomic>
+
+/**
+ * Voicing style template expressed as data (see "Style Templates Data Structure"
+ * in HarmonyScape_ChordEngine_Algorithm.md). Extension and interval sets are
+ * 12-bit masks: bit n means n semitones (mod 12) above the root, or between
+ * adjacent voices for the interval preferences.
+ */
+struct VoicingStyleTemplate
+{
+    const char* id = "";
+    const char* name = "";
+    float defaultDensity = 0.5f;        // Suggested density setting (0.0-1.0)
+    uint16_t preferredExtensions = 0;   // Extensions to prioritise
+    uint16_t avoidedExtensions = 0;     // Extensions to avoid
+    float rootBassFrequency = 0.5f;     // How strongly root-in-bass voicings are favoured (0.0-1.0)
+    int minVoices = 1;                  // Voice count range
+    int maxVoices = VoicingCandidate::MAX_NOTES;
+    uint16_t preferredIntervals = 0;    // Adjacent-voice intervals to favour
+    uint16_t avoidedIntervals = 0;      // Adjacent-voice intervals to avoid
+};
+
+/**
+ * A style compiled against the voicing dictionary: for every (quality, density level)
+ * entry, the dictionary candidates re-ranked by the style. This is the only form the
+ * audio thread sees, for factory and user styles alike.
+ */
+struct CompiledVoicingStyle
+{
+    static constexpr int MAX_NAME_LENGTH = 32;
+
+    struct Entry
+    {
+        uint8_t order[VoicingDictionary::CANDIDATES_PER_ENTRY] {};   // Candidate indices, best first
+        uint8_t scores[VoicingDictionary::CANDIDATES_PER_ENTRY] {};  // Style-adjusted cost per ranked slot
+        uint8_t numCandidates = 0;
+    };
+
+    char name[MAX_NAME_LENGTH] {};
+    float defaultDensity = 0.5f;
+    std::array<Entry, VoicingDictionaryBuilder::NUM_ENTRIES> entries {};
+
+    const Entry& getEntry(ChordQuality quality, int densityLevel) const
+    {
+        const int q = juce::jlimit(0, NUM_CHORD_QUALITIES - 1, static_cast<int>(quality));
+        const int level = juce::jlimit(0, NUM_DENSITY_LEVELS - 1, densityLevel);
+        return entries[static_cast<size_t>(q * NUM_DENSITY_LEVELS + level)];
+    }
+};
+
+/**
+ * Compiles style templates into CompiledVoicingStyle tables.
+ * Everything is constexpr so factory styles are compiled by the compiler; user
+ * styles go through the same function at runtime on a background thread.
+ */
+struct VoicingStyleCompiler
+{
+    static constexpr int scoreCandidate(const VoicingCandidate& candidate, const VoicingStyleTemplate& style)
+    {
+        int cost = candidate.score;
+        const int numNotes = candidate.numNotes;
+
+        // Voice counts outside the style's range are heavily discouraged but not removed,
+        // so every entry still has something to play
+        if (numNotes < style.minVoices || numNotes > style.maxVoices)
+            cost += 60;
+
+        bool hasBass = false;
+        for (int i = 0; i < numNotes; ++i)
+        {
+            const int offset = candidate.offsets[i];
+            const int pitchClass = ((offset % 12) + 12) % 12;
+
+            if (offset < 0)
+                hasBass = true;
+
+            if ((style.avoidedExtensions & (1 << pitchClass)) != 0)
+                cost += 20;
+            else if ((style.preferredExtensions & (1 << pitchClass)) != 0)
+                cost -= 5;
+
+            if (i > 0)
+            {
+                const int intervalClass = (offset - candidate.offsets[i - 1]) % 12;
+                if ((style.avoidedIntervals & (1 << intervalClass)) != 0)
+                    cost += 8;
+                else if ((style.preferredIntervals & (1 << intervalClass)) != 0)
+                    cost -= 2;
+            }
+        }
+
+        // Root-in-bass preference
+        const int bassWeight = static_cast<int>(style.rootBassFrequency * 10.0f);
+        cost += hasBass ? -bassWeight : bassWeight / 2;
+
+        return cost < 0 ? 0 : (cost > 254 ? 254 : cost);
+    }
+
+    static constexpr CompiledVoicingStyle compile(const VoicingStyleTemplate& style)
+    {
+        CompiledVoicingStyle compiled {};
+
+        for (int i = 0; i < CompiledVoicingStyle::MAX_NAME_LENGTH - 1 && style.name[i] != 0; ++i)
+            compiled.name[i] = style.name[i];
+
+        compiled.defaultDensity = style.defaultDensity;
+
+        for (int e = 0; e < VoicingDictionaryBuilder::NUM_ENTRIES; ++e)
+        {
+            auto& entry = compiled.entries[static_cast<size_t>(e)];
+            const int base = e * VoicingDictionary::CANDIDATES_PER_ENTRY;
+
+            for (int c = 0; c < VoicingDictionary::CANDIDATES_PER_ENTRY; ++c)
+            {
+                const auto& candidate = VoicingDictionary::table[static_cast<size_t>(base + c)];
+                if (candidate.numNotes == 0)
+                    break;
+
+                const auto score = static_cast<uint8_t>(scoreCandidate(candidate, style));
+
+                // Insertion into the ranked list
+                int position = entry.numCandidates;
+                while (position > 0 && entry.scores[position - 1] > score)
+                {
+                    entry.order[position] = entry.order[position - 1];
+                    entry.scores[position] = entry.scores[position - 1];
+                    --position;
+                }
+
+                entry.order[position] = static_cast<uint8_t>(c);
+                entry.scores[position] = score;
+                ++entry.numCandidates;
+            }
+        }
+
+        return compiled;
+    }
+
+    static constexpr uint16_t mask(std::initializer_list<int> pitchClasses)
+    {
+        uint16_t result = 0;
+        for (int pc : pitchClasses)
+            result = static_cast<uint16_t>(result | (1 << (((pc % 12) + 12) % 12)));
+        return result;
+    }
+};
+
+/**
+ * Factory voicing styles. Index 0 keeps the dictionary's own ranking.
+ */
+struct FactoryVoicingStyles
+{
+    static constexpr int NUM_STYLES = 4;
+
+    static constexpr std::array<VoicingStyleTemplate, NUM_STYLES> templates {{
+        // id, name, density, preferred ext, avoided ext, root bass, voices, preferred intervals, avoided intervals
+        { "default", "Default", 0.5f, 0, 0, 0.5f, 1, 6, 0, 0 },
+        { "jazz", "Jazz", 0.7f,
+          VoicingStyleCompiler::mask({ 2, 9, 10, 11 }), VoicingStyleCompiler::mask({ 0 }),
+          0.3f, 3, 5,
+          VoicingStyleCompiler::mask({ 3, 4, 5 }), VoicingStyleCompiler::mask({ 1 }) },
+        { "neosoul", "Neo-Soul", 0.8f,
+          VoicingStyleCompiler::mask({ 2, 5, 10 }), VoicingStyleCompiler::mask({ 6 }),
+          0.6f, 3, 6,
+          VoicingStyleCompiler::mask({ 2, 5 }), VoicingStyleCompiler::mask({ 1, 11 }) },
+        { "cinematic", "Cinematic", 0.6f,
+          VoicingStyleCompiler::mask({ 0, 7, 2 }), VoicingStyleCompiler::mask({ 6, 10, 11 }),
+          1.0f, 2, 6,
+          VoicingStyleCompiler::mask({ 0, 5, 7 }), VoicingStyleCompiler::mask({ 1, 2, 6 }) },
+    }};
+
+    static constexpr std::array<CompiledVoicingStyle, NUM_STYLES> compiled {{
+        VoicingStyleCompiler::compile(templates[0]),
+        VoicingStyleCompiler::compile(templates[1]),
+        VoicingStyleCompiler::compile(templates[2]),
+        VoicingStyleCompiler::compile(templates[3]),
+    }};
+
+    static juce::StringArray getNames()
+    {
+        juce::StringArray names;
+        for (const auto& style : templates)
+            names.add(style.name);
+        return names;
+    }
+};
+
+/**
+ * VoicingStyleLibrary owns the active style published to the audio thread.
+ *
+ * Factory styles are selected by pointing at their constexpr tables. User style
+ * files (JSON, in the Styles folder) are parsed and compiled on a background
+ * thread and published into fixed slots with atomic pointer stores. Selecting
+ * either kind is an atomic pointer swap, and the audio thread only ever performs
+ * an acquire load, so switching styles neither allocates nor blocks it.
+ *
+ * Compiled user styles stay alive for the lifetime of the library, so a pointer
+ * the audio thread has loaded can never dangle.
+ */
+class VoicingStyleLibrary
+{
+public:
+    static constexpr int MAX_USER_STYLES = 32;
+
+    VoicingStyleLibrary();
+    ~VoicingStyleLibrary();
+
+    /** Audio thread: the currently published style (never null). */
+    const CompiledVoicingStyle& getActiveStyle() const noexcept
+    {
+        return *activeStyle.load(std::memory_order_acquire);
+    }
+
+    /** Any thread: publish one of the factory styles. */
+    void selectFactoryStyle(int index) noexcept;
+
+    /** Index of the selected factory style, or -1 if a user style is active. */
+    int getSelectedFactoryStyle() const noexcept { return selectedFactoryStyle.load(); }
+
+    /**
+     * Parses and compiles the .json styles in a directory in the background, in
+     * file name order, replacing any user styles loaded before. The style at index
+     * i always comes from the i-th file; a file that fails to parse leaves its
+     * slot empty. Returns false if the directory doesn't exist.
+     */
+    bool loadUserStylesAsync(const juce::File& directory);
+
+    /** Where user styles are looked for by default */
+    static juce::File getUserStyleDirectory();
+
+    /** User style slots filled so far, including empty ones for files that failed to parse */
+    int getNumUserStyles() const noexcept { return numUserStyles.load(); }
+
+    /** Name of the user style in a slot, or an empty string if the slot is empty */
+    juce::String getUserStyleName(int index) const;
+
+    /**
+     * Any thread: publish a loaded user style. Wait-free.
+     * @return False if the style isn't loaded (yet); the active style is unchanged then
+     */
+    bool selectUserStyle(int index) noexcept;
+
+    /**
+     * Parses a JSON style description into a template (strings are owned by the caller).
+     * Returns false if the JSON isn't an object.
+     */
+    static bool parseStyleTemplate(const juce::var& json, VoicingStyleTemplate& style,
+                                   juce::String& idStorage, juce::String& nameStorage);
+
+private:
+    std::atomic<const CompiledVoicingStyle*> activeStyle;
+    std::atomic<int> selectedFactoryStyle { 0 };
+
+    std::array<std::atomic<const CompiledVoicingStyle*>, MAX_USER_STYLES> userStyleSlots {};
+    std::atomic<int> numUserStyles { 0 };
+
+    // Background compilation of user styles, on the loader thread shared by all instances
+    juce::SharedResourcePointer<BackgroundLoader> loader;
+    juce::CriticalSection userStylesLock;
+    juce::OwnedArray<CompiledVoicingStyle> userStyles;
+
+    JUCE_DECLARE_NON_COPYABLE (VoicingStyleLibrary)
+};
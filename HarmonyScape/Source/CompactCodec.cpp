@@ -0,0 +1,171 @@
+#include "CompactCodec.h"
+#include <array>
+#include <cstring>
+
+uint32_t CompactCodec::read32(const uint8_t* p) noexcept
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+int CompactCodec::hash(uint32_t sequence) noexcept
+{
+    return static_cast<int>((sequence * 2654435761u) >> (32 - hashBits));
+}
+
+// Writes the 255-run continuation of a length whose nibble was saturated
+bool CompactCodec::writeLength(uint8_t*& out, const uint8_t* end, int length) noexcept
+{
+    for (; length >= 255; length -= 255)
+    {
+        if (out == end)
+            return false;
+        *out++ = 255;
+    }
+
+    if (out == end)
+        return false;
+
+    *out++ = static_cast<uint8_t>(length);
+    return true;
+}
+
+bool CompactCodec::readLength(const uint8_t*& in, const uint8_t* end, int& length) noexcept
+{
+    for (;;)
+    {
+        if (in == end)
+            return false;
+
+        const int next = *in++;
+        length += next;
+
+        if (next != 255)
+            return true;
+    }
+}
+
+bool CompactCodec::writeSequence(uint8_t*& out, const uint8_t* end, const uint8_t* literals, int numLiterals,
+                                 int matchLength, int offset) noexcept
+{
+    if (out == end)
+        return false;
+
+    const int literalNibble = numLiterals < 15 ? numLiterals : 15;
+    const int matchNibble = matchLength == 0 ? 0 : (matchLength - minMatch < 15 ? matchLength - minMatch : 15);
+    *out++ = static_cast<uint8_t>((literalNibble << 4) | matchNibble);
+
+    if (literalNibble == 15 && !writeLength(out, end, numLiterals - 15))
+        return false;
+
+    if (end - out < numLiterals)
+        return false;
+
+    if (numLiterals > 0)
+        std::memcpy(out, literals, static_cast<size_t>(numLiterals));
+    out += numLiterals;
+
+    if (matchLength == 0)
+        return true;
+
+    if (end - out < 2)
+        return false;
+
+    *out++ = static_cast<uint8_t>(offset & 0xff);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+
+    return matchNibble < 15 || writeLength(out, end, matchLength - minMatch - 15);
+}
+
+int CompactCodec::compress(const uint8_t* source, int sourceSize, uint8_t* dest, int destCapacity) noexcept
+{
+    std::array<int, 1 << hashBits> table;
+    table.fill(-1);
+
+    uint8_t* out = dest;
+    const uint8_t* const outEnd = dest + destCapacity;
+
+    int anchor = 0;     // Start of the pending literal run
+    int position = 0;
+
+    while (position + minMatch <= sourceSize)
+    {
+        const uint32_t sequence = read32(source + position);
+        auto& slot = table[static_cast<size_t>(hash(sequence))];
+        const int candidate = slot;
+        slot = position;
+
+        if (candidate < 0 || position - candidate > maxOffset || read32(source + candidate) != sequence)
+        {
+            ++position;
+            continue;
+        }
+
+        int matchLength = minMatch;
+        while (position + matchLength < sourceSize && source[candidate + matchLength] == source[position + matchLength])
+            ++matchLength;
+
+        if (!writeSequence(out, outEnd, source + anchor, position - anchor, matchLength, position - candidate))
+            return -1;
+
+        position += matchLength;
+        anchor = position;
+    }
+
+    // Trailing literals end the block
+    if (!writeSequence(out, outEnd, source + anchor, sourceSize - anchor, 0, 0))
+        return -1;
+
+    return static_cast<int>(out - dest);
+}
+
+bool CompactCodec::decompress(const uint8_t* source, int sourceSize, uint8_t* dest, int decodedSize) noexcept
+{
+    const uint8_t* in = source;
+    const uint8_t* const inEnd = source + sourceSize;
+    uint8_t* out = dest;
+    uint8_t* const outEnd = dest + decodedSize;
+
+    while (in < inEnd)
+    {
+        const int token = *in++;
+
+        int numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(in, inEnd, numLiterals))
+            return false;
+
+        if (inEnd - in < numLiterals || outEnd - out < numLiterals)
+            return false;
+
+        if (numLiterals > 0)
+            std::memcpy(out, in, static_cast<size_t>(numLiterals));
+        in += numLiterals;
+        out += numLiterals;
+
+        // Only the last sequence ends without a match
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+
+        const int offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        int matchLength = token & 0x0f;
+        if (matchLength == 15 && !readLength(in, inEnd, matchLength))
+            return false;
+        matchLength += minMatch;
+
+        if (offset == 0 || offset > out - dest || outEnd - out < matchLength)
+            return false;
+
+        // Byte by byte: a match may overlap the bytes it produces
+        const uint8_t* match = out - offset;
+        for (int i = 0; i < matchLength; ++i)
+            *out++ = match[i];
+    }
+
+    return out == outEnd;
+}
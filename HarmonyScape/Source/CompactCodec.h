@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Small LZ77 byte codec in the style of an LZ4 block: sequences of literal runs
+ * followed by back-references into the already decoded output.
+ *
+ * Built for small payloads such as plugin state, where it runs in well under a
+ * microsecond per hundred bytes and needs no allocation or external library.
+ * Each sequence is a token byte (literal count in the high nibble, match length
+ * minus 4 in the low nibble, 15 meaning "more length bytes follow"), the
+ * literals, then a 16-bit little-endian match offset. The final sequence has
+ * literals only.
+ */
+struct CompactCodec
+{
+    /** Largest compressed size of sourceSize bytes (incompressible input) */
+    static constexpr int getMaxCompressedSize(int sourceSize) noexcept
+    {
+        return sourceSize + sourceSize / 255 + 16;
+    }
+
+    /**
+     * Compresses source into dest.
+     * @return The compressed size, or -1 if it wouldn't fit in destCapacity
+     */
+    static int compress(const uint8_t* source, int sourceSize, uint8_t* dest, int destCapacity) noexcept;
+
+    /**
+     * Decompresses exactly decodedSize bytes.
+     * @return False if the input is malformed or doesn't decode to decodedSize bytes
+     */
+    static bool decompress(const uint8_t* source, int sourceSize, uint8_t* dest, int decodedSize) noexcept;
+
+private:
+    static constexpr int minMatch = 4;
+    static constexpr int maxOffset = 65535;
+    static constexpr int hashBits = 12;
+
+    static uint32_t read32(const uint8_t* p) noexcept;
+    static int hash(uint32_t sequence) noexcept;
+    static bool writeLength(uint8_t*& out, const uint8_t* end, int length) noexcept;
+    static bool readLength(const uint8_t*& in, const uint8_t* end, int& length) noexcept;
+    static bool writeSequence(uint8_t*& out, const uint8_t* end, const uint8_t* literals, int numLiterals,
+                              int matchLength, int offset) noexcept;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "SpatialEngine/SpatialEngine.h"
+#include "RibbonEngine/RibbonEngine.h"
+#include <array>
+#include <bitset>
+
+/**
+ * What the editor displays of the audio thread's state, published once per block
+ * through a TripleBuffer while an editor is open. Plain data, so the audio thread
+ * fills it without allocating and the editor reads it without locking.
+ */
+struct EditorTelemetry
+{
+    using NoteSet = std::bitset<128>;
+
+    NoteSet userNotes;              // Input keys held
+    NoteSet generatedNotes;         // Harmony notes held
+    NoteSet soundingNotes;          // Notes with an audible voice, releases included
+
+    // Every audible voice's note, pan (-1 to 1, width applied) and level
+    std::array<SpatialEngine::VoiceTelemetry, SpatialEngine::MAX_VOICES> voices;
+    int numVoices = 0;
+
+    int chordId = -1;               // ChordEngine::getCurrentChordId(), -1 without a chord
+
+    // Sequence step each running ribbon played last
+    std::array<int, RibbonEngine::MAX_RIBBONS> ribbonSteps {};
+    int numRibbons = 0;
+};
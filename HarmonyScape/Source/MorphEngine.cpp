@@ -0,0 +1,107 @@
+#include "MorphEngine.h"
+
+MorphEngine::MorphEngine(juce::AudioProcessorValueTreeState& parameters, const PresetBank& bank,
+                         const ParameterSnapshotManager& snapshot)
+    : presetBank(bank), parameterSnapshot(snapshot)
+{
+    loadedSlots.fill(-2);   // Not a slot value, so the first setSlots always loads
+
+    for (auto* parameter : parameters.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parameterList.push_back(ranged);
+
+    jassert(parameterList.size() <= static_cast<size_t>(MAX_PARAMETERS));
+    numParameters = juce::jmin(static_cast<int>(parameterList.size()), MAX_PARAMETERS);
+
+    // The morph's own parameters are never morphed, so they aren't listed
+    for (int i = 0; i < numParameters; ++i)
+    {
+        if (parameterList[static_cast<size_t>(i)]->isDiscrete()
+            && parameterSnapshot.getParameterGroup(i) != ParameterSnapshot::Morph)
+        {
+            discreteParameters[static_cast<size_t>(numDiscrete++)] = i;
+            layered[static_cast<size_t>(i)] = parameterSnapshot.isLayerBlended(i);
+        }
+    }
+}
+
+bool MorphEngine::setSlots(const std::array<int, ParameterSnapshot::NUM_MORPH_SLOTS>& slots)
+{
+    // The morph position moving doesn't need the presets converted again
+    if (slots == loadedSlots && !needsRebuild())
+        return false;
+
+    loadedSlots = slots;
+    numSlots = 0;
+    missingPresets = false;
+    numKnownPresets = presetBank.getNumPresets();
+
+    for (const int slot : slots)
+    {
+        if (slot < 0)
+            continue;
+
+        const auto* preset = presetBank.getPreset(slot);
+        if (preset == nullptr)
+        {
+            // Within the bank but not published yet: still loading
+            missingPresets |= slot < numKnownPresets;
+            continue;
+        }
+
+        auto& dest = slotValues[static_cast<size_t>(numSlots++)];
+        for (int i = 0; i < numParameters; ++i)
+        {
+            const auto* parameter = parameterList[static_cast<size_t>(i)];
+            const float value = i < preset->numValues ? preset->values[static_cast<size_t>(i)]
+                                                      : parameter->getDefaultValue();
+            dest[static_cast<size_t>(i)] = parameter->convertFrom0to1(value);
+        }
+    }
+
+    // Steps between neighbouring slots, and the groups they touch
+    morphedGroups = 0;
+    for (int slot = 0; slot < numSlots - 1; ++slot)
+    {
+        auto& delta = slotDeltas[static_cast<size_t>(slot)];
+        juce::FloatVectorOperations::subtract(delta.data(), slotValues[static_cast<size_t>(slot + 1)].data(),
+                                              slotValues[static_cast<size_t>(slot)].data(), numParameters);
+
+        for (int i = 0; i < numParameters; ++i)
+            if (!juce::approximatelyEqual(delta[static_cast<size_t>(i)], 0.0f))
+                morphedGroups |= parameterSnapshot.getParameterGroup(i);
+    }
+
+    morphedGroups &= ~static_cast<uint32_t>(ParameterSnapshot::Morph);
+    upperSlot = juce::jmin(upperSlot, juce::jmax(0, numSlots - 1));
+    blendAmount = 0.0f;
+    return true;
+}
+
+void MorphEngine::evaluate(float position) noexcept
+{
+    if (!isActive())
+        return;
+
+    const float scaled = juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(numSlots - 1);
+    const int lowerSlot = juce::jmin(static_cast<int>(scaled), numSlots - 2);
+    const float t = scaled - static_cast<float>(lowerSlot);
+
+    // Continuous parameters: lower + (upper - lower) * t over the whole vector
+    juce::FloatVectorOperations::copy(values.data(), slotValues[static_cast<size_t>(lowerSlot)].data(), numParameters);
+    juce::FloatVectorOperations::addWithMultiply(values.data(), slotDeltas[static_cast<size_t>(lowerSlot)].data(),
+                                                 t, numParameters);
+
+    upperSlot = lowerSlot + 1;
+    blendAmount = t;
+
+    // Discrete parameters: layered ones stay on the lower slot and are crossfaded
+    // by blendAmount, the others switch to the nearer slot
+    const int nearestSlot = t < 0.5f ? lowerSlot : upperSlot;
+    for (int i = 0; i < numDiscrete; ++i)
+    {
+        const auto index = static_cast<size_t>(discreteParameters[static_cast<size_t>(i)]);
+        const int sourceSlot = layered[index] ? lowerSlot : nearestSlot;
+        values[index] = slotValues[static_cast<size_t>(sourceSlot)][index];
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "ParameterSnapshot.h"
+#include "PresetBank.h"
+#include <array>
+#include <vector>
+
+/**
+ * Morphs every plugin parameter continuously across up to four presets from a
+ * single macro position.
+ *
+ * When the slots change, their presets are converted once into plain value
+ * vectors in processor parameter order, together with the difference between
+ * each neighbouring pair. Evaluating a position is then one vectorised
+ * copy-and-multiply-add over the whole parameter vector, run at control rate:
+ * once per block, and only when the position moves.
+ *
+ * Discrete parameters can't be interpolated. The ones the engines can layer
+ * (waveform, ribbon patterns) keep the lower slot's value, and the upper slot's
+ * is crossfaded in by getBlendAmount(); the rest switch halfway between slots.
+ *
+ * Everything but the constructor runs on the audio thread and doesn't allocate.
+ */
+class MorphEngine
+{
+public:
+    MorphEngine(juce::AudioProcessorValueTreeState& parameters, const PresetBank& presetBank,
+                const ParameterSnapshotManager& parameterSnapshot);
+
+    /**
+     * Loads the presets of the morph slots (-1 = empty); empty slots are skipped.
+     * @return False if nothing changed since the last call
+     */
+    bool setSlots(const std::array<int, ParameterSnapshot::NUM_MORPH_SLOTS>& slots);
+
+    /** True while a slot's preset is still loading, so setSlots needs calling again */
+    bool needsRebuild() const noexcept { return missingPresets || presetBank.getNumPresets() != numKnownPresets; }
+
+    /** Whether at least two slots are loaded, so there is something to morph between */
+    bool isActive() const noexcept { return numSlots >= 2; }
+
+    /** Groups with a parameter that differs between slots: the ones a morph overrides */
+    uint32_t getMorphedGroups() const noexcept { return morphedGroups; }
+
+    /** Evaluates the morph at position (0-1 across the loaded slots) */
+    void evaluate(float position) noexcept;
+
+    /** Plain values of the last evaluate(), indexed like the processor's parameters */
+    const float* getValues() const noexcept { return values.data(); }
+
+    /** Plain values of the slot being morphed towards, for the layered parameters */
+    const float* getUpperValues() const noexcept { return slotValues[static_cast<size_t>(upperSlot)].data(); }
+
+    /** How far the layered parameters are crossfaded towards getUpperValues() */
+    float getBlendAmount() const noexcept { return blendAmount; }
+
+private:
+    static constexpr int MAX_PARAMETERS = PresetSnapshot::MAX_PARAMETERS;
+    static constexpr int MAX_SLOTS = ParameterSnapshot::NUM_MORPH_SLOTS;
+
+    const PresetBank& presetBank;
+    const ParameterSnapshotManager& parameterSnapshot;
+    std::vector<juce::RangedAudioParameter*> parameterList;
+    int numParameters = 0;
+
+    // Plain values of the loaded slots, and the step from each to the next
+    alignas(16) std::array<std::array<float, MAX_PARAMETERS>, MAX_SLOTS> slotValues {};
+    alignas(16) std::array<std::array<float, MAX_PARAMETERS>, MAX_SLOTS - 1> slotDeltas {};
+    alignas(16) std::array<float, MAX_PARAMETERS> values {};
+    int numSlots = 0;
+    std::array<int, MAX_SLOTS> loadedSlots;     // As last passed to setSlots
+
+    // Discrete parameters, by processor index, and whether each one is layered
+    std::array<int, MAX_PARAMETERS> discreteParameters {};
+    std::array<bool, MAX_PARAMETERS> layered {};
+    int numDiscrete = 0;
+
+    uint32_t morphedGroups = 0;
+    bool missingPresets = false;
+    int numKnownPresets = 0;        // Bank size when the slots were loaded
+    float blendAmount = 0.0f;
+    int upperSlot = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (MorphEngine)
+};
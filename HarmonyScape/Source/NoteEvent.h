@@ -0,0 +1,152 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <array>
+#include <cstdint>
+
+/**
+ * A note start or end as it travels between the engines.
+ *
+ * ChordEngine, RibbonEngine and SpatialEngine exchange these instead of MIDI
+ * messages, so what an engine knows about a note (its pan, the layer it came
+ * from, its place in the chord) reaches the renderer intact. MIDI is only
+ * decoded at the plugin boundary.
+ */
+struct NoteEvent
+{
+    // Engine layer a note comes from
+    enum class Source : uint8_t
+    {
+        Input,      // Played by the user
+        Harmony,    // Generated voicing from ChordEngine
+        Ribbon      // Arpeggiated ribbon note from RibbonEngine
+    };
+
+    int samplePosition = 0;     // Offset within the current block
+    uint8_t noteNumber = 60;
+    uint8_t channel = 1;        // MIDI channel the note belongs to (1-16)
+    bool isNoteOn = true;
+    Source source = Source::Input;
+    int8_t voiceHint = -1;      // Position in the chord or ribbon step that produced the note, -1 if unknown
+    float velocity = 1.0f;      // 0.0-1.0
+    float pan = 0.0f;           // -1.0 (left) to 1.0 (right), only used if hasPan
+    bool hasPan = false;        // False lets SpatialEngine place the note itself
+
+    static NoteEvent noteOn(int samplePosition, int channel, int noteNumber, float velocity,
+                            Source source, int voiceHint = -1)
+    {
+        NoteEvent event;
+        event.samplePosition = samplePosition;
+        event.noteNumber = static_cast<uint8_t>(juce::jlimit(0, 127, noteNumber));
+        event.channel = static_cast<uint8_t>(juce::jlimit(1, 16, channel));
+        event.isNoteOn = true;
+        event.source = source;
+        event.voiceHint = static_cast<int8_t>(juce::jlimit(-1, 127, voiceHint));
+        event.velocity = velocity;
+        return event;
+    }
+
+    static NoteEvent noteOff(int samplePosition, int channel, int noteNumber, Source source)
+    {
+        NoteEvent event;
+        event.samplePosition = samplePosition;
+        event.noteNumber = static_cast<uint8_t>(juce::jlimit(0, 127, noteNumber));
+        event.channel = static_cast<uint8_t>(juce::jlimit(1, 16, channel));
+        event.isNoteOn = false;
+        event.source = source;
+        event.velocity = 0.0f;
+        return event;
+    }
+};
+
+/**
+ * Preallocated list of the note events in one block. Adding never allocates;
+ * events beyond the capacity are dropped and counted.
+ */
+class NoteEventBuffer
+{
+public:
+    static constexpr int CAPACITY = 2048;
+
+    void clear() noexcept { numEvents = 0; }
+    bool isEmpty() const noexcept { return numEvents == 0; }
+    int size() const noexcept { return numEvents; }
+
+    /** Appends an event. Returns false (and drops the event) if the buffer is full. */
+    bool add(const NoteEvent& event) noexcept
+    {
+        if (numEvents == CAPACITY)
+        {
+            ++numDropped;
+            return false;
+        }
+
+        events[static_cast<size_t>(numEvents++)] = event;
+        return true;
+    }
+
+    /**
+     * Appends the note-ons and note-offs of a MIDI buffer, in its (sample) order.
+     * Reads the raw bytes directly, so controllers, aftertouch and everything else
+     * cost one status byte check and no juce::MidiMessage is built. A note-on with
+     * velocity 0 becomes a note-off.
+     */
+    void addMidi(const juce::MidiBuffer& midi, NoteEvent::Source source) noexcept
+    {
+        for (const auto metadata : midi)
+        {
+            if (metadata.numBytes < 3)
+                continue;
+
+            const auto* data = metadata.data;
+            const int status = data[0] & 0xf0;
+            if (status != 0x90 && status != 0x80)
+                continue;
+
+            const int channel = (data[0] & 0x0f) + 1;
+            const int noteNumber = data[1] & 0x7f;
+            const int velocity = data[2] & 0x7f;
+
+            if (status == 0x90 && velocity > 0)
+                add(NoteEvent::noteOn(metadata.samplePosition, channel, noteNumber, velocity / 127.0f, source));
+            else
+                add(NoteEvent::noteOff(metadata.samplePosition, channel, noteNumber, source));
+        }
+    }
+
+    /**
+     * Orders the events by sample position. Events at the same position keep the
+     * order they were added in, as they would in a MidiBuffer.
+     */
+    void sort() noexcept
+    {
+        // Insertion sort: stable, allocation-free, and each engine already adds its
+        // events in order, so there is little to move
+        for (int i = 1; i < numEvents; ++i)
+        {
+            const auto event = events[static_cast<size_t>(i)];
+            int j = i;
+
+            while (j > 0 && events[static_cast<size_t>(j - 1)].samplePosition > event.samplePosition)
+            {
+                events[static_cast<size_t>(j)] = events[static_cast<size_t>(j - 1)];
+                --j;
+            }
+
+            events[static_cast<size_t>(j)] = event;
+        }
+    }
+
+    juce::Span<const NoteEvent> getEvents() const noexcept { return { events.data(), static_cast<size_t>(numEvents) }; }
+
+    const NoteEvent* begin() const noexcept { return events.data(); }
+    const NoteEvent* end() const noexcept { return events.data() + numEvents; }
+
+    /** Events lost to a full buffer since construction */
+    uint32_t getNumDropped() const noexcept { return numDropped; }
+
+private:
+    std::array<NoteEvent, CAPACITY> events {};
+    int numEvents = 0;
+    uint32_t numDropped = 0;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <vector>
+
+/**
+ * Turns a block-rate parameter into a per-sample ramp.
+ *
+ * The target can change once per block (as host automation or a UI change is
+ * picked up); getNextBlock() then writes the glide towards it into a buffer
+ * preallocated by prepare(), which render loops read like any other signal.
+ * SmoothingType is juce::ValueSmoothingTypes::Linear or ::Multiplicative (an
+ * exponential glide, for strictly positive values only).
+ */
+template <typename SmoothingType = juce::ValueSmoothingTypes::Linear>
+class ParameterRamp
+{
+public:
+    /**
+     * Allocates the ramp buffer and sets the glide time. The ramp jumps to its
+     * target, so a prepare never glides from a stale value.
+     * @param sampleRate The sample rate the ramp is rendered at
+     * @param maximumBlockSize Largest numSamples getNextBlock() will be asked for
+     * @param rampLengthSeconds Time to reach a new target
+     */
+    void prepare(double sampleRate, int maximumBlockSize, double rampLengthSeconds)
+    {
+        ramp.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), smoothed.getTargetValue());
+        smoothed.reset(sampleRate, rampLengthSeconds);
+        ramping = false;
+    }
+
+    /** Starts a glide towards a new value (no-op if it is already the target) */
+    void setTargetValue(float newTarget) noexcept { smoothed.setTargetValue(newTarget); }
+
+    /** Jumps straight to a value */
+    void setCurrentAndTargetValue(float newValue) noexcept { smoothed.setCurrentAndTargetValue(newValue); }
+
+    float getTargetValue() const noexcept { return smoothed.getTargetValue(); }
+    float getCurrentValue() const noexcept { return smoothed.getCurrentValue(); }
+
+    /** Largest block getNextBlock() can fill */
+    int getMaximumBlockSize() const noexcept { return static_cast<int>(ramp.size()); }
+
+    /**
+     * Audio thread: the values for the next numSamples samples.
+     * numSamples must not exceed getMaximumBlockSize().
+     */
+    const float* getNextBlock(int numSamples) noexcept
+    {
+        jassert(numSamples <= getMaximumBlockSize());
+        numSamples = juce::jmin(numSamples, getMaximumBlockSize());
+
+        ramping = smoothed.isSmoothing();
+
+        if (ramping)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                ramp[static_cast<size_t>(i)] = smoothed.getNextValue();
+        }
+        else
+        {
+            juce::FloatVectorOperations::fill(ramp.data(), smoothed.getTargetValue(), numSamples);
+        }
+
+        return ramp.data();
+    }
+
+    /**
+     * Whether the last block's values changed along the block. When false every
+     * value equals the target, so a renderer may treat it as a constant.
+     */
+    bool isRamping() const noexcept { return ramping; }
+
+private:
+    juce::SmoothedValue<float, SmoothingType> smoothed;
+    std::vector<float> ramp;
+    bool ramping = false;
+};
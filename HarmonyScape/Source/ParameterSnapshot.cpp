@@ -0,0 +1,236 @@
+#include "ParameterSnapshot.h"
+
+ParameterSnapshotManager::ParameterSnapshotManager(juce::AudioProcessorValueTreeState& parametersToWatch)
+    : parameters(parametersToWatch)
+{
+    const auto numParameters = static_cast<size_t>(parameters.processor.getParameters().size());
+    rawValues.resize(numParameters, nullptr);
+    parameterGroups.resize(numParameters, 0);
+
+    auto makeListener = [this](uint32_t group) -> GroupListener&
+    {
+        listeners.push_back(std::make_unique<GroupListener>(*this, group));
+        return *listeners.back();
+    };
+
+    auto& chord = makeListener(ParameterSnapshot::Chord);
+    listen("chordDensity", chord, chordDensity);
+    listen("voicingStyle", chord, voicingStyle);
+    listen("userStyle", chord, userStyle);
+    listen("captureWindow", chord, captureWindow);
+
+    auto& zones = makeListener(ParameterSnapshot::Zones);
+    listen("zoneMode", zones, zoneMode);
+    listen("splitPoint", zones, splitPoint);
+    listen("lowerZoneDensity", zones, lowerZoneDensity);
+
+    auto& output = makeListener(ParameterSnapshot::Output);
+    listen("spatialWidth", output, spatialWidth);
+    listen("waveform", output, waveform);
+    listen("volume", output, volume);
+
+    auto& envelope = makeListener(ParameterSnapshot::Envelope);
+    listen("attack", envelope, attack);
+    listen("decay", envelope, decay);
+    listen("sustain", envelope, sustain);
+    listen("release", envelope, release);
+
+    auto& spatial = makeListener(ParameterSnapshot::Spatial);
+    listen("movementRate", spatial, movementRate);
+    listen("movementDepth", spatial, movementDepth);
+    listen("height", spatial, height);
+    listen("depth", spatial, depth);
+    listen("enableMovement", spatial, enableMovement);
+
+    auto& ribbons = makeListener(ParameterSnapshot::Ribbons);
+    listen("enableRibbons", ribbons, enableRibbons);
+    listen("ribbonCount", ribbons, ribbonCount);
+    listen("ribbonRate", ribbons, ribbonRate);
+    listen("ribbonSpread", ribbons, ribbonSpread);
+    listen("ribbonIntensity", ribbons, ribbonIntensity);
+    listen("ribbonSync", ribbons, ribbonSync);
+
+    for (int i = 0; i < ParameterSnapshot::NUM_RIBBON_PARAM_SETS; ++i)
+    {
+        const juce::String prefix = "ribbon" + juce::String(i + 1);
+        auto& set = ribbonParams[static_cast<size_t>(i)];
+        listen(prefix + "Enable", ribbons, set.enable);
+        listen(prefix + "Pattern", ribbons, set.pattern);
+        listen(prefix + "Rate", ribbons, set.rate);
+        listen(prefix + "Offset", ribbons, set.offset);
+    }
+
+    auto& rhythm = makeListener(ParameterSnapshot::Rhythm);
+    listen("swing", rhythm, swing);
+    listen("groove", rhythm, groove);
+    listen("shimmer", rhythm, shimmer);
+    listen("shimmerRate", rhythm, shimmerRate);
+    listen("enableRhythm", rhythm, enableRhythm);
+
+    auto& morph = makeListener(ParameterSnapshot::Morph);
+    listen("morphEnable", morph, morphEnable);
+    listen("morph", morph, morphPosition);
+
+    for (int i = 0; i < ParameterSnapshot::NUM_MORPH_SLOTS; ++i)
+        listen("morphSlot" + juce::String(i + 1), morph, morphSlots[static_cast<size_t>(i)]);
+
+    // Everything starts dirty, so the first update() reads every group
+    readGroups(ParameterSnapshot::allGroups, nullptr);
+}
+
+ParameterSnapshotManager::~ParameterSnapshotManager()
+{
+    for (const auto& registration : registrations)
+        parameters.removeParameterListener(registration.first, registration.second);
+}
+
+void ParameterSnapshotManager::listen(const juce::String& parameterID, GroupListener& listener, int& index)
+{
+    auto* parameter = parameters.getParameter(parameterID);
+    jassert(parameter != nullptr);
+
+    index = parameter->getParameterIndex();
+    rawValues[static_cast<size_t>(index)] = parameters.getRawParameterValue(parameterID);
+    parameterGroups[static_cast<size_t>(index)] = listener.group;
+
+    parameters.addParameterListener(parameterID, &listener);
+    registrations.emplace_back(parameterID, &listener);
+}
+
+void ParameterSnapshotManager::markDirty(uint32_t groups)
+{
+    // The raw value is already stored when listeners are called; the version is
+    // bumped last so a reader that sees it also sees the dirty bits
+    dirtyGroups.fetch_or(groups, std::memory_order_relaxed);
+    version.fetch_add(1, std::memory_order_release);
+}
+
+uint32_t ParameterSnapshotManager::update()
+{
+    const uint32_t currentVersion = version.load(std::memory_order_acquire);
+    if (currentVersion == lastVersion)
+        return 0;
+
+    // A change landing after this point bumps the version again and is picked up
+    // by the next update
+    lastVersion = currentVersion;
+    const uint32_t groups = dirtyGroups.exchange(0, std::memory_order_acq_rel);
+    readGroups(groups, nullptr);
+    return groups;
+}
+
+void ParameterSnapshotManager::setLayerBlend(const float* otherValues, float amount)
+{
+    auto& blend = snapshot.layerBlend;
+
+    if (otherValues == nullptr || amount <= 0.0f)
+    {
+        blend = {};
+        return;
+    }
+
+    blend.amount = amount;
+    blend.waveform = static_cast<SpatialEngine::WaveformType>(static_cast<int>(otherValues[waveform]));
+
+    for (size_t i = 0; i < ribbonParams.size(); ++i)
+        blend.patterns[i] = static_cast<int>(otherValues[ribbonParams[i].pattern]);
+}
+
+bool ParameterSnapshotManager::isLayerBlended(int index) const
+{
+    if (index == waveform)
+        return true;
+
+    for (const auto& set : ribbonParams)
+        if (index == set.pattern)
+            return true;
+
+    return false;
+}
+
+void ParameterSnapshotManager::readGroups(uint32_t groups, const float* plainValues)
+{
+    auto& s = snapshot;
+
+    auto value = [&](int index)
+    {
+        return plainValues != nullptr ? plainValues[index]
+                                      : rawValues[static_cast<size_t>(index)]->load();
+    };
+
+    if ((groups & ParameterSnapshot::Chord) != 0)
+    {
+        s.chordDensity = value(chordDensity);
+        s.voicingStyle = static_cast<int>(value(voicingStyle));
+        s.userStyle = static_cast<int>(value(userStyle)) - 1;     // Counts files from 1; 0 is none
+        s.captureWindowMs = value(captureWindow);
+    }
+
+    if ((groups & ParameterSnapshot::Zones) != 0)
+    {
+        s.zoneMode = static_cast<int>(value(zoneMode));
+        s.splitPoint = static_cast<int>(value(splitPoint));
+        s.lowerZoneDensity = value(lowerZoneDensity);
+    }
+
+    if ((groups & ParameterSnapshot::Output) != 0)
+    {
+        s.spatialWidth = value(spatialWidth);
+        s.waveform = static_cast<SpatialEngine::WaveformType>(static_cast<int>(value(waveform)));
+        s.volume = value(volume);
+    }
+
+    if ((groups & ParameterSnapshot::Envelope) != 0)
+    {
+        s.adsr.attack = value(attack);
+        s.adsr.decay = value(decay);
+        s.adsr.sustain = value(sustain);
+        s.adsr.release = value(release);
+    }
+
+    if ((groups & ParameterSnapshot::Spatial) != 0)
+    {
+        s.spatial.movementRate = value(movementRate);
+        s.spatial.movementDepth = value(movementDepth);
+        s.spatial.height = value(height);
+        s.spatial.depth = value(depth);
+        s.spatial.enableMovement = value(enableMovement) > 0.5f;
+    }
+
+    if ((groups & ParameterSnapshot::Ribbons) != 0)
+    {
+        s.enableRibbons = value(enableRibbons) > 0.5f;
+        s.ribbonCount = static_cast<int>(value(ribbonCount));
+        s.ribbonRate = value(ribbonRate);
+        s.ribbonSpread = value(ribbonSpread);
+        s.ribbonIntensity = value(ribbonIntensity);
+        s.ribbonSync = value(ribbonSync) > 0.5f;
+
+        for (size_t i = 0; i < ribbonParams.size(); ++i)
+        {
+            s.ribbons[i].enabled = value(ribbonParams[i].enable) > 0.5f;
+            s.ribbons[i].pattern = static_cast<int>(value(ribbonParams[i].pattern));
+            s.ribbons[i].rate = value(ribbonParams[i].rate);
+            s.ribbons[i].offset = value(ribbonParams[i].offset);
+        }
+    }
+
+    if ((groups & ParameterSnapshot::Rhythm) != 0)
+    {
+        s.rhythm.swing = value(swing);
+        s.rhythm.groove = value(groove);
+        s.rhythm.shimmer = value(shimmer);
+        s.rhythm.shimmerRate = value(shimmerRate);
+        s.rhythm.enableRhythm = value(enableRhythm) > 0.5f;
+    }
+
+    if ((groups & ParameterSnapshot::Morph) != 0)
+    {
+        s.morphEnabled = value(morphEnable) > 0.5f;
+        s.morphPosition = value(morphPosition);
+
+        // Slot parameters count programs from 1; 0 leaves the slot empty
+        for (size_t i = 0; i < morphSlots.size(); ++i)
+            s.morphSlots[i] = static_cast<int>(value(morphSlots[i])) - 1;
+    }
+}
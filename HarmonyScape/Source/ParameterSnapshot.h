@@ -0,0 +1,221 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "SpatialEngine/SpatialEngine.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * Plain copy of every plugin parameter, as the audio thread sees it for a block.
+ * Values are grouped by what they feed, so a change only invalidates the derived
+ * state of its own group.
+ */
+struct alignas(64) ParameterSnapshot
+{
+    // Parameter groups, used as bits of a dirty mask
+    enum Group : uint32_t
+    {
+        Chord    = 1u << 0,     // Density, voicing and user style, capture window
+        Zones    = 1u << 1,     // Keyboard split / channel zones
+        Output   = 1u << 2,     // Width, waveform, volume
+        Envelope = 1u << 3,     // ADSR
+        Spatial  = 1u << 4,     // Spatial movement
+        Ribbons  = 1u << 5,     // Ribbon engine
+        Rhythm   = 1u << 6,     // Legacy rhythmic parameters
+        Morph    = 1u << 7,     // Preset morph macro and slots
+        allGroups = (1u << 8) - 1
+    };
+
+    static constexpr int NUM_RIBBON_PARAM_SETS = 3;
+    static constexpr int NUM_MORPH_SLOTS = 4;
+
+    // Chord
+    float chordDensity = 0.5f;
+    int voicingStyle = 0;
+    int userStyle = -1;                 // User style file in use instead, -1 for none
+    float captureWindowMs = 0.0f;
+
+    // Zones
+    int zoneMode = 0;
+    int splitPoint = 60;
+    float lowerZoneDensity = 0.3f;
+
+    // Output
+    float spatialWidth = 0.5f;
+    SpatialEngine::WaveformType waveform = SpatialEngine::WaveformType::Sine;
+    float volume = 0.7f;
+
+    // Envelope, spatial and rhythm, in the form the spatial engine takes them
+    SpatialEngine::ADSRParams adsr { 0.1f, 0.1f, 0.7f, 0.2f };
+    SpatialEngine::SpatialParams spatial;
+    SpatialEngine::RhythmParams rhythm;
+
+    // Ribbons
+    bool enableRibbons = true;
+    int ribbonCount = 2;
+    float ribbonRate = 0.5f;
+    float ribbonSpread = 0.6f;
+    float ribbonIntensity = 0.8f;
+    bool ribbonSync = false;
+
+    // Parameters of the ribbons with their own controls
+    struct RibbonParamSet
+    {
+        bool enabled = false;
+        int pattern = 0;
+        float rate = 0.5f;
+        float offset = 0.0f;
+    };
+    std::array<RibbonParamSet, NUM_RIBBON_PARAM_SETS> ribbons;
+
+    // Morph
+    bool morphEnabled = false;
+    float morphPosition = 0.0f;
+    std::array<int, NUM_MORPH_SLOTS> morphSlots {};     // Preset per slot, -1 if empty
+
+    // Discrete parameters a morph crossfades instead of switching: their values on
+    // the far side of the morph, and how far towards them it is (0 = no blend)
+    struct LayerBlend
+    {
+        float amount = 0.0f;
+        SpatialEngine::WaveformType waveform = SpatialEngine::WaveformType::Sine;
+        std::array<int, NUM_RIBBON_PARAM_SETS> patterns {};
+    };
+    LayerBlend layerBlend;
+};
+
+/**
+ * Keeps a ParameterSnapshot up to date without the audio thread polling every
+ * parameter.
+ *
+ * Value tree listeners mark a parameter's group dirty and bump a version counter
+ * from whichever thread changes it. The audio thread compares the version once
+ * per block and, only when it moved, re-reads the dirty groups and reports them,
+ * so derived values are recomputed for exactly the groups that changed.
+ *
+ * Groups can also be filled from a vector of plain values in processor
+ * parameter order, which is how a preset morph overrides the parameters.
+ */
+class ParameterSnapshotManager
+{
+public:
+    explicit ParameterSnapshotManager(juce::AudioProcessorValueTreeState& parameters);
+    ~ParameterSnapshotManager();
+
+    /**
+     * Audio thread (single reader): refreshes the snapshot if any parameter
+     * changed since the last call.
+     * @return The groups that were re-read, 0 if nothing changed
+     */
+    uint32_t update();
+
+    /**
+     * The snapshot as of the last update()
+     */
+    const ParameterSnapshot& get() const { return snapshot; }
+
+    /** Audio thread: re-reads groups from the parameters themselves */
+    void reread(uint32_t groups) { readGroups(groups, nullptr); }
+
+    /**
+     * Audio thread: fills groups from plain values indexed like the processor's
+     * parameter list, instead of from the parameters.
+     */
+    void applyValues(const float* plainValues, uint32_t groups) { readGroups(groups, plainValues); }
+
+    /**
+     * Audio thread: sets the snapshot's layer blend from the values on the far side
+     * of a morph (indexed like applyValues), or clears it if otherValues is null.
+     */
+    void setLayerBlend(const float* otherValues, float amount);
+
+    /** Number of parameters in the processor's list */
+    int getNumParameters() const { return static_cast<int>(parameterGroups.size()); }
+
+    /** The group of a parameter by processor index (0 for parameters not in the snapshot) */
+    uint32_t getParameterGroup(int index) const { return parameterGroups[static_cast<size_t>(index)]; }
+
+    /** Whether a parameter (by processor index) is crossfaded through the layer blend */
+    bool isLayerBlended(int index) const;
+
+private:
+    // Forwards changes of one group's parameters
+    struct GroupListener : public juce::AudioProcessorValueTreeState::Listener
+    {
+        GroupListener(ParameterSnapshotManager& ownerToNotify, uint32_t groupToMark)
+            : owner(ownerToNotify), group(groupToMark) {}
+
+        void parameterChanged(const juce::String&, float) override { owner.markDirty(group); }
+
+        ParameterSnapshotManager& owner;
+        uint32_t group;
+    };
+
+    void markDirty(uint32_t groups);
+    void listen(const juce::String& parameterID, GroupListener& listener, int& index);
+    void readGroups(uint32_t groups, const float* plainValues);
+
+    juce::AudioProcessorValueTreeState& parameters;
+    std::vector<std::unique_ptr<GroupListener>> listeners;
+    std::vector<std::pair<juce::String, GroupListener*>> registrations;
+
+    // Raw parameter values and groups, by processor parameter index
+    std::vector<std::atomic<float>*> rawValues;
+    std::vector<uint32_t> parameterGroups;
+
+    // Processor index of each parameter
+    int chordDensity = -1;
+    int voicingStyle = -1;
+    int userStyle = -1;
+    int captureWindow = -1;
+    int zoneMode = -1;
+    int splitPoint = -1;
+    int lowerZoneDensity = -1;
+    int spatialWidth = -1;
+    int waveform = -1;
+    int volume = -1;
+    int attack = -1;
+    int decay = -1;
+    int sustain = -1;
+    int release = -1;
+    int movementRate = -1;
+    int movementDepth = -1;
+    int height = -1;
+    int depth = -1;
+    int enableMovement = -1;
+    int enableRibbons = -1;
+    int ribbonCount = -1;
+    int ribbonRate = -1;
+    int ribbonSpread = -1;
+    int ribbonIntensity = -1;
+    int ribbonSync = -1;
+
+    struct RibbonParamSet
+    {
+        int enable = -1;
+        int pattern = -1;
+        int rate = -1;
+        int offset = -1;
+    };
+    std::array<RibbonParamSet, ParameterSnapshot::NUM_RIBBON_PARAM_SETS> ribbonParams;
+
+    int swing = -1;
+    int groove = -1;
+    int shimmer = -1;
+    int shimmerRate = -1;
+    int enableRhythm = -1;
+
+    int morphEnable = -1;
+    int morphPosition = -1;
+    std::array<int, ParameterSnapshot::NUM_MORPH_SLOTS> morphSlots {};
+
+    // Change tracking: writers set dirty bits, then bump the version
+    std::atomic<uint32_t> dirtyGroups { ParameterSnapshot::allGroups };
+    std::atomic<uint32_t> version { 1 };
+    uint32_t lastVersion = 0;               // Audio thread only
+
+    ParameterSnapshot snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterSnapshotManager)
+};
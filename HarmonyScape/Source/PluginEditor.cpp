@@ -73,9 +73,11 @@ HarmonyScapeAudioProcessorEditor::HarmonyScapeAudioProcessorEditor (HarmonyScape
     customKeyboard.setAvailableRange(36, 96); // 5 octaves
     customKeyboard.setOctaveForMiddleC(4);
     customKeyboard.setLowestVisibleKey(48); // C3
+    customKeyboard.setComponentID("keyboard");
     addAndMakeVisible(customKeyboard);
     
     // ADSR visualizer
+    adsrVisualizer.setComponentID("adsrVisualizer");
     addAndMakeVisible(adsrVisualizer);
     
     // Set up new ribbon controls
@@ -85,13 +87,19 @@ HarmonyScapeAudioProcessorEditor::HarmonyScapeAudioProcessorEditor (HarmonyScape
     setupSpatialControls();
     
     // Set up spatial visualizer
+    spatialVisualizer.setComponentID("spatialVisualizer");
     addAndMakeVisible(spatialVisualizer);
     
     // Create all parameter attachments
     createParameterAttachments();
 
-    // Start timer to update the keyboard display
-    startTimerHz(24); // Refresh at 24Hz for smooth display
+    // Refresh the displays from the audio thread's telemetry, on the timer shared
+    // by every open editor
+    audioProcessor.attachTelemetryReader();
+    refreshScheduler->addClient(*this);
+    
+    // The cached background covers the whole editor
+    setOpaque (true);
     
     // Set editor size
     setSize (1200, 800);  // Increased size for new controls
@@ -99,11 +107,14 @@ HarmonyScapeAudioProcessorEditor::HarmonyScapeAudioProcessorEditor (HarmonyScape
 
 HarmonyScapeAudioProcessorEditor::~HarmonyScapeAudioProcessorEditor()
 {
-    stopTimer();
+    refreshScheduler->removeClient(*this);
+    audioProcessor.detachTelemetryReader();
 }
 
 void HarmonyScapeAudioProcessorEditor::setupRibbonControls()
 {
+    const int firstRibbonChild = getNumChildComponents();
+    
     auto setupLabel = [this](juce::Label& label, const juce::String& text) {
         label.setText(text, juce::dontSendNotification);
         label.setJustificationType(juce::Justification::centred);
@@ -124,6 +135,9 @@ void HarmonyScapeAudioProcessorEditor::setupRibbonControls()
     enableRibbonsButton.setButtonText("Enable Ribbons");
     enableRibbonsButton.setToggleState(true, juce::dontSendNotification);
     
+    addAndMakeVisible(ribbonSyncButton);
+    ribbonSyncButton.setButtonText("Tempo Sync");
+    
     addAndMakeVisible(ribbonsHeaderLabel);
     ribbonsHeaderLabel.setText("RHYTHMIC RIBBONS", juce::dontSendNotification);
     ribbonsHeaderLabel.setFont(juce::Font(14.0f, juce::Font::bold));
@@ -132,7 +146,7 @@ void HarmonyScapeAudioProcessorEditor::setupRibbonControls()
     
     // Global ribbon controls
     setupRotaryKnob(ribbonCountSlider);
-    ribbonCountSlider.setRange(1, 5, 1);
+    ribbonCountSlider.setRange(1, RibbonEngine::MAX_RIBBONS, 1);
     ribbonCountSlider.setValue(2);
     setupLabel(ribbonCountLabel, "Count");
     
@@ -199,6 +213,10 @@ void HarmonyScapeAudioProcessorEditor::setupRibbonControls()
         setupLabel(ribbon.rateLabel, "Rate");
         setupLabel(ribbon.offsetLabel, "Offset");
     }
+    
+    // One ID for the whole section, so tools such as the paint benchmark can find it
+    for (int i = firstRibbonChild; i < getNumChildComponents(); ++i)
+        getChildComponent(i)->setComponentID("ribbonControls");
 }
 
 void HarmonyScapeAudioProcessorEditor::setupSpatialControls()
@@ -267,6 +285,7 @@ void HarmonyScapeAudioProcessorEditor::createParameterAttachments()
     
     // Ribbon attachments
     enableRibbonsAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(valueTreeState, "enableRibbons", enableRibbonsButton));
+    ribbonSyncAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(valueTreeState, "ribbonSync", ribbonSyncButton));
     ribbonCountAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(valueTreeState, "ribbonCount", ribbonCountSlider));
     ribbonRateAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(valueTreeState, "ribbonRate", ribbonRateSlider));
     ribbonSpreadAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(valueTreeState, "ribbonSpread", ribbonSpreadSlider));
@@ -292,6 +311,12 @@ void HarmonyScapeAudioProcessorEditor::createParameterAttachments()
 
 //==============================================================================
 void HarmonyScapeAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Everything the editor draws itself is static, so it comes from the cache
+    backgroundLayer.draw(g, getLocalBounds(), [this](juce::Graphics& layer) { paintBackground(layer); });
+}
+
+void HarmonyScapeAudioProcessorEditor::paintBackground (juce::Graphics& g)
 {
     // Fill the background
     g.fillAll (juce::Colours::darkgrey);
@@ -366,6 +391,8 @@ void HarmonyScapeAudioProcessorEditor::paint (juce::Graphics& g)
 
 void HarmonyScapeAudioProcessorEditor::resized()
 {
+    backgroundLayer.invalidate();
+    
     const int labelHeight = 20;
     const int sliderHeight = 80;
     const int itemWidth = 120;
@@ -444,8 +471,10 @@ void HarmonyScapeAudioProcessorEditor::layoutRibbonControls()
     ribbonsHeaderLabel.setBounds(ribbonSection.removeFromTop(25));
     ribbonSection.removeFromTop(5);
     
-    // Enable button
-    enableRibbonsButton.setBounds(ribbonSection.removeFromTop(25).reduced(40, 0));
+    // Enable and sync buttons
+    auto buttonRow = ribbonSection.removeFromTop(25);
+    enableRibbonsButton.setBounds(buttonRow.removeFromLeft(buttonRow.getWidth() / 2).withTrimmedLeft(10));
+    ribbonSyncButton.setBounds(buttonRow.withTrimmedLeft(10));
     ribbonSection.removeFromTop(5);
     
     // Global controls in 2x2 grid - made larger for knobs
@@ -551,33 +580,37 @@ void HarmonyScapeAudioProcessorEditor::layoutSpatialControls()
     }
 }
 
-void HarmonyScapeAudioProcessorEditor::timerCallback()
+bool HarmonyScapeAudioProcessorEditor::refresh()
 {
-    // Clamp notes to visible keyboard range
-    auto clampNotes = [](const juce::Array<int>& notes) {
-        juce::Array<int> clamped;
-        for (auto n : notes) {
-            if (n >= 36 && n <= 96) clamped.add(n);
-        }
-        return clamped;
-    };
+    // Hidden or minimised: nothing to draw, and nothing to stay fast for
+    if (!isShowing())
+        return false;
     
-    customKeyboard.setUserNotes(clampNotes(audioProcessor.getUserInputNotes()));
-    customKeyboard.setGeneratedNotes(clampNotes(audioProcessor.getGeneratedNotes()));
+    const bool changed = updateFromProcessor();
+    return changed || isMouseOver(true);
+}
+
+bool HarmonyScapeAudioProcessorEditor::updateFromProcessor()
+{
+    // Latest block's state from the audio thread; no copies of shared arrays, no locks
+    const auto& telemetry = audioProcessor.readTelemetry();
+    bool changed = telemetry.numVoices > 0;
+    changed |= customKeyboard.setNotes(telemetry.userNotes, telemetry.generatedNotes);
+    spatialVisualizer.setVoices(telemetry);
     
     // Update ADSR visualizer
     float attack = *valueTreeState.getRawParameterValue("attack");
     float decay = *valueTreeState.getRawParameterValue("decay");
     float sustain = *valueTreeState.getRawParameterValue("sustain");
     float release = *valueTreeState.getRawParameterValue("release");
-    adsrVisualizer.setADSR(attack, decay, sustain, release);
+    changed |= adsrVisualizer.setADSR(attack, decay, sustain, release);
     
     // Update spatial visualizer
     float spatialWidth = *valueTreeState.getRawParameterValue("spatialWidth");
     float height = *valueTreeState.getRawParameterValue("height");
     float depth = *valueTreeState.getRawParameterValue("depth");
     bool movement = *valueTreeState.getRawParameterValue("enableMovement") > 0.5f;
-    spatialVisualizer.setSpatialParams(spatialWidth, height, depth, movement);
+    changed |= spatialVisualizer.setSpatialParams(spatialWidth, height, depth, movement);
     
     // Update chord density description based on current value
     float density = *valueTreeState.getRawParameterValue("chordDensity");
@@ -589,4 +622,6 @@ void HarmonyScapeAudioProcessorEditor::timerCallback()
         chordDensityDescLabel.setText("Rich harmony", juce::dontSendNotification);
     else
         chordDensityDescLabel.setText("Full voicing", juce::dontSendNotification);
+    
+    return changed;
 } 
\ No newline at end of file
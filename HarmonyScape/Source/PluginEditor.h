@@ -2,13 +2,15 @@
 
 #include "JuceHeader.h"
 #include "PluginProcessor.h"
+#include "CachedLayer.h"
+#include "RefreshScheduler.h"
 
 //==============================================================================
 /**
  * HarmonyScape plugin editor with enhanced UI controls for ribbons and spatial features
  */
 class HarmonyScapeAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                          private juce::Timer
+                                          private RefreshScheduler::Client
 {
 public:
     HarmonyScapeAudioProcessorEditor (HarmonyScapeAudioProcessor&, juce::AudioProcessorValueTreeState&);
@@ -18,10 +20,18 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     
-    // Timer callback for updating the keyboard display
-    void timerCallback() override;
+    /**
+     * Brings the displays up to date with the audio thread's telemetry and the
+     * parameters, repainting only what changed.
+     * @return True if voices are sounding or anything on screen changed
+     */
+    bool updateFromProcessor();
 
 private:
+    // Called by the shared scheduler: nothing while hidden, full rate while active
+    bool refresh() override;
+    juce::SharedResourcePointer<RefreshScheduler> refreshScheduler;
+    
     // Setup methods for UI components
     void setupRibbonControls();
     void setupSpatialControls();
@@ -29,6 +39,10 @@ private:
     void layoutRibbonControls();
     void layoutSpatialControls();
     
+    // Section frames, titles and legend, drawn into backgroundLayer
+    void paintBackground(juce::Graphics& g);
+    CachedLayer backgroundLayer;
+    
     // Reference to our processor
     HarmonyScapeAudioProcessor& audioProcessor;
     
@@ -40,8 +54,6 @@ private:
     
     // UI Components - Keyboard display
     juce::MidiKeyboardComponent midiKeyboard;
-    juce::Array<int> userNotes;     // Notes played by user
-    juce::Array<int> generatedNotes; // Notes generated by chord engine
     
     // UI Components - Synth controls
     juce::ComboBox waveformCombo;
@@ -68,6 +80,7 @@ private:
     
     // New UI Components - Ribbon Controls
     juce::ToggleButton enableRibbonsButton;
+    juce::ToggleButton ribbonSyncButton;
     juce::Label ribbonsLabel;
     juce::Label ribbonsHeaderLabel;
     juce::Slider ribbonCountSlider;
@@ -117,6 +130,7 @@ private:
     
     // Parameter attachments - Ribbons
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> enableRibbonsAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> ribbonSyncAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ribbonCountAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ribbonRateAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ribbonSpreadAttachment;
@@ -149,16 +163,21 @@ private:
             this->setColour(juce::MidiKeyboardComponent::keyDownOverlayColourId, juce::Colours::blue);
         }
         
-        void setUserNotes(const juce::Array<int>& notes) 
-        { 
-            userNotesList = notes; 
-            repaint();
-        }
-        
-        void setGeneratedNotes(const juce::Array<int>& notes) 
-        { 
-            generatedNotesList = notes; 
-            repaint();
+        // Repaints only the keys whose colour changed; returns false if none did
+        bool setNotes(const EditorTelemetry::NoteSet& userNotes, const EditorTelemetry::NoteSet& generatedNotes)
+        {
+            const auto changed = (userNotes ^ userNotesList) | (generatedNotes ^ generatedNotesList);
+            if (changed.none())
+                return false;
+            
+            userNotesList = userNotes;
+            generatedNotesList = generatedNotes;
+            
+            for (int note = getRangeStart(); note <= getRangeEnd(); ++note)
+                if (changed[static_cast<size_t>(note)])
+                    repaint(getRectangleForKey(note).getSmallestIntegerContainer());
+            
+            return true;
         }
         
     protected:
@@ -205,16 +224,16 @@ private:
     private:
         bool isUserNote(int midiNoteNumber) const
         {
-            return userNotesList.contains(midiNoteNumber);
+            return userNotesList[static_cast<size_t>(midiNoteNumber & 127)];
         }
         
         bool isGeneratedNote(int midiNoteNumber) const
         {
-            return generatedNotesList.contains(midiNoteNumber) && !userNotesList.contains(midiNoteNumber);
+            return generatedNotesList[static_cast<size_t>(midiNoteNumber & 127)] && !isUserNote(midiNoteNumber);
         }
         
-        juce::Array<int> userNotesList;
-        juce::Array<int> generatedNotesList;
+        EditorTelemetry::NoteSet userNotesList;
+        EditorTelemetry::NoteSet generatedNotesList;
     };
     
     // Implement custom keyboard to show colored keys
@@ -226,129 +245,204 @@ private:
     public:
         ADSRVisualizer() {}
         
-        void setADSR(float a, float d, float s, float r)
+        // Repaints only when the envelope actually changed; returns false if it didn't
+        bool setADSR(float a, float d, float s, float r)
         {
+            if (juce::approximatelyEqual(a, attack) && juce::approximatelyEqual(d, decay)
+                && juce::approximatelyEqual(s, sustain) && juce::approximatelyEqual(r, release))
+                return false;
+            
             attack = a;
             decay = d;
             sustain = s;
             release = r;
+            updateEnvelope();
             repaint();
+            return true;
+        }
+        
+        void resized() override
+        {
+            background.invalidate();
+            updateEnvelope();
         }
         
         void paint(juce::Graphics& g) override
         {
-            auto bounds = getLocalBounds().reduced(10);
-            
-            // Background
-            g.setColour(juce::Colours::black.withAlpha(0.5f));
-            g.fillRoundedRectangle(bounds.toFloat(), 5.0f);
-            
-            // Grid lines
-            g.setColour(juce::Colours::grey.withAlpha(0.3f));
-            const int gridLines = 4;
-            for (int i = 1; i < gridLines; ++i)
+            // Background and grid lines only change with the size
+            background.draw(g, getLocalBounds(), [this](juce::Graphics& layer)
             {
-                float y = bounds.getY() + (bounds.getHeight() * i / gridLines);
-                g.drawHorizontalLine(static_cast<int>(y), static_cast<float>(bounds.getX()), static_cast<float>(bounds.getRight()));
-            }
-            
-            // Calculate ADSR curve points
-            const float maxTime = 4.0f; // Max 4 seconds total time
-            const float totalTime = attack + decay + release + 0.5f; // 0.5f for sustain display
-            const float timeScale = bounds.getWidth() / std::max(totalTime, 1.0f);
-            
-            juce::Path envelope;
-            
-            // Start point
-            float x = static_cast<float>(bounds.getX());
-            float y = static_cast<float>(bounds.getBottom());
-            envelope.startNewSubPath(x, y);
-            
-            // Attack point (peak)
-            x += attack * timeScale;
-            y = static_cast<float>(bounds.getY());
-            envelope.lineTo(x, y);
-            
-            // Decay point (to sustain level)
-            x += decay * timeScale;
-            y = bounds.getY() + bounds.getHeight() * (1.0f - sustain);
-            envelope.lineTo(x, y);
-            
-            // Sustain (hold for display)
-            x += 0.5f * timeScale;
-            envelope.lineTo(x, y);
-            
-            // Release point (back to zero)
-            x += release * timeScale;
-            y = static_cast<float>(bounds.getBottom());
-            envelope.lineTo(x, y);
+                auto bounds = getLocalBounds().reduced(10);
+                
+                layer.setColour(juce::Colours::black.withAlpha(0.5f));
+                layer.fillRoundedRectangle(bounds.toFloat(), 5.0f);
+                
+                layer.setColour(juce::Colours::grey.withAlpha(0.3f));
+                const int gridLines = 4;
+                for (int i = 1; i < gridLines; ++i)
+                {
+                    float y = bounds.getY() + (bounds.getHeight() * i / gridLines);
+                    layer.drawHorizontalLine(static_cast<int>(y), static_cast<float>(bounds.getX()), static_cast<float>(bounds.getRight()));
+                }
+            });
             
             // Draw the envelope curve
             g.setColour(juce::Colours::cyan);
-            g.strokePath(envelope, juce::PathStrokeType(2.0f));
+            g.fillPath(envelopeStroke);
             
             // Draw control points as small circles
             g.setColour(juce::Colours::white);
             const float circleRadius = 4.0f;
-            
-            // Attack point
-            x = bounds.getX() + attack * timeScale;
-            y = static_cast<float>(bounds.getY());
-            g.fillEllipse(x - circleRadius, y - circleRadius, circleRadius * 2, circleRadius * 2);
-            
-            // Decay/Sustain point
-            x = bounds.getX() + (attack + decay) * timeScale;
-            y = bounds.getY() + bounds.getHeight() * (1.0f - sustain);
-            g.fillEllipse(x - circleRadius, y - circleRadius, circleRadius * 2, circleRadius * 2);
-            
-            // Release start point
-            x = bounds.getX() + (attack + decay + 0.5f) * timeScale;
-            g.fillEllipse(x - circleRadius, y - circleRadius, circleRadius * 2, circleRadius * 2);
+            for (const auto& point : controlPoints)
+                g.fillEllipse(point.x - circleRadius, point.y - circleRadius, circleRadius * 2, circleRadius * 2);
             
             // Labels
             g.setColour(juce::Colours::lightgrey);
             g.setFont(10.0f);
-            g.drawText("A", bounds.getX(), bounds.getBottom() + 2, 20, 12, juce::Justification::centred);
-            g.drawText("D", bounds.getX() + attack * timeScale, bounds.getBottom() + 2, 20, 12, juce::Justification::centred);
-            g.drawText("S", bounds.getX() + (attack + decay) * timeScale, bounds.getBottom() + 2, 20, 12, juce::Justification::centred);
-            g.drawText("R", bounds.getX() + (attack + decay + 0.5f) * timeScale, bounds.getBottom() + 2, 20, 12, juce::Justification::centred);
+            const int labelY = getLocalBounds().reduced(10).getBottom() + 2;
+            const char* const labels[] = { "A", "D", "S", "R" };
+            for (size_t i = 0; i < labelX.size(); ++i)
+                g.drawText(labels[i], static_cast<int>(labelX[i]), labelY, 20, 12, juce::Justification::centred);
         }
         
     private:
+        // Rebuilds the stroked curve, control points and label positions
+        void updateEnvelope()
+        {
+            auto bounds = getLocalBounds().reduced(10);
+            
+            const float totalTime = attack + decay + release + 0.5f; // 0.5f for sustain display
+            const float timeScale = bounds.getWidth() / std::max(totalTime, 1.0f);
+            
+            const float left = static_cast<float>(bounds.getX());
+            const float top = static_cast<float>(bounds.getY());
+            const float bottom = static_cast<float>(bounds.getBottom());
+            const float attackX = left + attack * timeScale;
+            const float decayX = attackX + decay * timeScale;
+            const float releaseX = decayX + 0.5f * timeScale;
+            const float sustainY = bounds.getY() + bounds.getHeight() * (1.0f - sustain);
+            
+            juce::Path envelope;
+            envelope.startNewSubPath(left, bottom);
+            envelope.lineTo(attackX, top);
+            envelope.lineTo(decayX, sustainY);
+            envelope.lineTo(releaseX, sustainY);
+            envelope.lineTo(releaseX + release * timeScale, bottom);
+            
+            envelopeStroke.clear();
+            juce::PathStrokeType(2.0f).createStrokedPath(envelopeStroke, envelope);
+            
+            controlPoints = { juce::Point<float>(attackX, top),
+                              juce::Point<float>(decayX, sustainY),
+                              juce::Point<float>(releaseX, sustainY) };
+            labelX = { left, attackX, decayX, releaseX };
+        }
+        
         float attack = 0.01f;
         float decay = 0.1f;
         float sustain = 0.7f;
         float release = 0.2f;
+        
+        CachedLayer background;
+        juce::Path envelopeStroke;                      // Envelope curve, already stroked
+        std::array<juce::Point<float>, 3> controlPoints;
+        std::array<float, 4> labelX {};
     };
     
     ADSRVisualizer adsrVisualizer;
     
-    // New Spatial Visualizer Component
+    // Spatial field: the spatial parameters, and every audible voice plotted by pan
+    // (across) and pitch (up), brighter the louder it is
     class SpatialVisualizer : public juce::Component
     {
     public:
+        // Most voice dots drawn per frame; more voices are thinned out evenly
+        static constexpr int MAX_POINTS = 256;
+        
         SpatialVisualizer() {}
         
-        void setSpatialParams(float width, float height, float depth, bool movement)
+        // Repaints only when a parameter actually changed; returns false if none did
+        bool setSpatialParams(float width, float height, float depth, bool movement)
         {
+            if (juce::approximatelyEqual(width, spatialWidth) && juce::approximatelyEqual(height, spatialHeight)
+                && juce::approximatelyEqual(depth, spatialDepth) && movement == movementEnabled)
+                return false;
+            
             spatialWidth = width;
             spatialHeight = height;
             spatialDepth = depth;
             movementEnabled = movement;
             repaint();
+            return true;
+        }
+        
+        // Takes the voices of the latest telemetry; repaints only where dots moved
+        void setVoices(const EditorTelemetry& telemetry)
+        {
+            const auto field = getLocalBounds().reduced(15).toFloat();
+            const int stride = (telemetry.numVoices + MAX_POINTS - 1) / MAX_POINTS;
+            
+            // Points are kept in device pixels at the scale last painted at, so motion
+            // too small to show doesn't count as a change
+            const float scale = dotScale > 0.0f ? dotScale : 1.0f;
+            
+            std::array<VoicePoint, MAX_POINTS> newPoints;
+            int numNewPoints = 0;
+            
+            for (int i = 0; i < telemetry.numVoices; i += juce::jmax(1, stride))
+            {
+                const auto& voice = telemetry.voices[static_cast<size_t>(i)];
+                const float pitch = juce::jlimit(0.0f, 1.0f, (voice.midiNote - lowestNote) / (highestNote - lowestNote));
+                
+                auto& point = newPoints[static_cast<size_t>(numNewPoints++)];
+                point.x = juce::roundToInt((field.getCentreX() + voice.pan * field.getWidth() * 0.5f) * scale);
+                point.y = juce::roundToInt((field.getBottom() - pitch * field.getHeight()) * scale);
+                point.alpha = static_cast<uint8_t>(juce::roundToInt(juce::jlimit(0.1f, 1.0f, voice.level * 1.5f) * 255.0f));
+                point.kind = voice.source == NoteEvent::Source::Input   ? userDot
+                           : voice.source == NoteEvent::Source::Harmony ? generatedDot
+                                                                        : ribbonDot;
+            }
+            
+            if (numNewPoints == numPoints && juce::approximatelyEqual(scale, pointScale)
+                && std::equal(newPoints.begin(), newPoints.begin() + numNewPoints, points.begin()))
+                return;
+            
+            // Where the dots were plus where they are now
+            juce::Rectangle<float> dirty;
+            for (int i = 0; i < numPoints; ++i)
+                dirty = dirty.getUnion(points[static_cast<size_t>(i)].getArea(pointScale));
+            for (int i = 0; i < numNewPoints; ++i)
+                dirty = dirty.getUnion(newPoints[static_cast<size_t>(i)].getArea(scale));
+            
+            points = newPoints;
+            numPoints = numNewPoints;
+            pointScale = scale;
+            repaint(dirty.getSmallestIntegerContainer().expanded(1));
+        }
+        
+        void resized() override
+        {
+            background.invalidate();
+            numPoints = 0;
         }
         
         void paint(juce::Graphics& g) override
         {
             auto bounds = getLocalBounds().reduced(5);
             
-            // Background
-            g.setColour(juce::Colours::black.withAlpha(0.7f));
-            g.fillRoundedRectangle(bounds.toFloat(), 3.0f);
-            
-            // Border
-            g.setColour(juce::Colours::grey.withAlpha(0.5f));
-            g.drawRoundedRectangle(bounds.toFloat(), 3.0f, 1.0f);
+            // Background, border and title only change with the size
+            background.draw(g, getLocalBounds(), [bounds](juce::Graphics& layer)
+            {
+                layer.setColour(juce::Colours::black.withAlpha(0.7f));
+                layer.fillRoundedRectangle(bounds.toFloat(), 3.0f);
+                
+                layer.setColour(juce::Colours::grey.withAlpha(0.5f));
+                layer.drawRoundedRectangle(bounds.toFloat(), 3.0f, 1.0f);
+                
+                layer.setColour(juce::Colours::lightgrey);
+                layer.setFont(9.0f);
+                layer.drawText("Spatial Field", bounds.getX() + 5, bounds.getY() + 2, 80, 12, juce::Justification::left);
+            });
             
             // Draw spatial field representation
             auto fieldBounds = bounds.reduced(10);
@@ -386,17 +480,93 @@ private:
                            1.0f, 6.0f, 4.0f);
             }
             
-            // Labels
-            g.setColour(juce::Colours::lightgrey);
-            g.setFont(9.0f);
-            g.drawText("Spatial Field", bounds.getX() + 5, bounds.getY() + 2, 80, 12, juce::Justification::left);
+            paintVoices(g);
         }
         
     private:
+        enum DotKind : uint8_t { userDot, generatedDot, ribbonDot, numDotKinds };
+        
+        static constexpr float dotRadius = 3.0f;
+        static constexpr float lowestNote = 24.0f;      // Pitch range of the vertical axis
+        static constexpr float highestNote = 108.0f;
+        
+        struct VoicePoint
+        {
+            int x = 0;              // Centre, in device pixels
+            int y = 0;
+            uint8_t alpha = 0;      // Opacity, 0-255
+            uint8_t kind = userDot;
+            
+            // The dot's bounds in component coordinates, for points taken at scale
+            juce::Rectangle<float> getArea(float scale) const
+            {
+                return { static_cast<float>(x) / scale - dotRadius, static_cast<float>(y) / scale - dotRadius,
+                         dotRadius * 2.0f, dotRadius * 2.0f };
+            }
+            
+            bool operator== (const VoicePoint& other) const
+            {
+                return x == other.x && y == other.y && alpha == other.alpha && kind == other.kind;
+            }
+        };
+        
+        // Blits one pre-rendered dot per voice, snapped to whole device pixels so
+        // the software renderer copies it without resampling
+        void paintVoices(juce::Graphics& g)
+        {
+            if (numPoints == 0)
+                return;
+            
+            const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            if (!juce::approximatelyEqual(scale, dotScale))
+                renderDots(scale);
+            
+            const auto clip = g.getClipBounds().toFloat();
+            for (int i = 0; i < numPoints; ++i)
+            {
+                const auto& point = points[static_cast<size_t>(i)];
+                auto area = point.getArea(pointScale);
+                if (!area.intersects(clip))
+                    continue;
+                
+                area.setPosition(std::round(area.getX() * scale) / scale, std::round(area.getY() * scale) / scale);
+                g.setOpacity(static_cast<float>(point.alpha) / 255.0f);
+                g.drawImage(dotImages[point.kind], area);
+            }
+            
+            g.setOpacity(1.0f);
+        }
+        
+        void renderDots(float scale)
+        {
+            const juce::Colour colours[numDotKinds] = { juce::Colours::blue.brighter(0.4f),
+                                                        juce::Colours::green.brighter(0.4f),
+                                                        juce::Colours::orange };
+            const int size = juce::jmax(1, juce::roundToInt(dotRadius * 2.0f * scale));
+            
+            for (size_t kind = 0; kind < dotImages.size(); ++kind)
+            {
+                dotImages[kind] = juce::Image(juce::Image::ARGB, size, size, true);
+                juce::Graphics dot(dotImages[kind]);
+                dot.setColour(colours[kind]);
+                dot.fillEllipse(0.0f, 0.0f, static_cast<float>(size), static_cast<float>(size));
+            }
+            
+            dotScale = scale;
+        }
+        
         float spatialWidth = 0.5f;
         float spatialHeight = 0.5f;
         float spatialDepth = 0.5f;
         bool movementEnabled = false;
+        
+        CachedLayer background;
+        
+        std::array<VoicePoint, MAX_POINTS> points;
+        int numPoints = 0;
+        std::array<juce::Image, numDotKinds> dotImages;
+        float dotScale = 0.0f;                          // Pixel scale dotImages were rendered at
+        float pointScale = 1.0f;                        // Pixel scale points were quantised at
     };
     
     SpatialVisualizer spatialVisualizer;
@@ -6,48 +6,21 @@ HarmonyScapeAudioProcessor::HarmonyScapeAudioProcessor()
     : AudioProcessor (BusesProperties()
                      .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                      .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-      parameters (*this, nullptr, "Parameters", createParameterLayout())
-{
-    // Get core parameter pointers
-    chordDensityParam = parameters.getRawParameterValue("chordDensity");
-    spatialWidthParam = parameters.getRawParameterValue("spatialWidth");
-    waveformParam = parameters.getRawParameterValue("waveform");
-    volumeParam = parameters.getRawParameterValue("volume");
-    attackParam = parameters.getRawParameterValue("attack");
-    decayParam = parameters.getRawParameterValue("decay");
-    sustainParam = parameters.getRawParameterValue("sustain");
-    releaseParam = parameters.getRawParameterValue("release");
-
-    // Get enhanced spatial parameter pointers
-    movementRateParam = parameters.getRawParameterValue("movementRate");
-    movementDepthParam = parameters.getRawParameterValue("movementDepth");
-    heightParam = parameters.getRawParameterValue("height");
-    depthParam = parameters.getRawParameterValue("depth");
-    enableMovementParam = parameters.getRawParameterValue("enableMovement");
-    
-    // Get ribbon parameter pointers
-    enableRibbonsParam = parameters.getRawParameterValue("enableRibbons");
-    ribbonCountParam = parameters.getRawParameterValue("ribbonCount");
-    ribbonRateParam = parameters.getRawParameterValue("ribbonRate");
-    ribbonSpreadParam = parameters.getRawParameterValue("ribbonSpread");
-    ribbonIntensityParam = parameters.getRawParameterValue("ribbonIntensity");
-    
-    // Get individual ribbon parameter pointers
-    for (int i = 0; i < 3; ++i)
-    {
-        juce::String prefix = "ribbon" + juce::String(i + 1);
-        ribbonParams[i].enable = parameters.getRawParameterValue(prefix + "Enable");
-        ribbonParams[i].pattern = parameters.getRawParameterValue(prefix + "Pattern");
-        ribbonParams[i].rate = parameters.getRawParameterValue(prefix + "Rate");
-        ribbonParams[i].offset = parameters.getRawParameterValue(prefix + "Offset");
-    }
+      parameters (*this, nullptr, "Parameters", createParameterLayout()),
+      parameterSnapshot (parameters),
+      presetBank (parameters),
+      morphEngine (parameters, presetBank, parameterSnapshot),
+      stateSerializer (parameters)
+{
+    // Fixed default seed so a fresh instance renders the same way every time
+    if (!parameters.state.hasProperty("randomSeed"))
+        setRandomSeed(RealtimeRandom::defaultSeed);
     
-    // Get legacy rhythmic parameter pointers
-    swingParam = parameters.getRawParameterValue("swing");
-    grooveParam = parameters.getRawParameterValue("groove");
-    shimmerParam = parameters.getRawParameterValue("shimmer");
-    shimmerRateParam = parameters.getRawParameterValue("shimmerRate");
-    enableRhythmParam = parameters.getRawParameterValue("enableRhythm");
+    ribbonLayerGain.fill(1.0f);
+    
+    presetBank.loadFactoryPresetsAsync();
+    presetBank.loadUserPresetsAsync(PresetBank::getUserPresetDirectory());
+    chordEngine.getStyleLibrary().loadUserStylesAsync(VoicingStyleLibrary::getUserStyleDirectory());
 }
 
 HarmonyScapeAudioProcessor::~HarmonyScapeAudioProcessor()
@@ -82,26 +55,23 @@ double HarmonyScapeAudioProcessor::getTailLengthSeconds() const
 
 int HarmonyScapeAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presetBank.getNumPresets();
 }
 
 int HarmonyScapeAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return juce::jmax(0, presetBank.getCurrentPreset());
 }
 
 void HarmonyScapeAudioProcessor::setCurrentProgram (int index)
 {
-    // Unused
-    juce::ignoreUnused(index);
+    // Applied by the audio thread at the start of a block
+    presetBank.selectPreset(index);
 }
 
 const juce::String HarmonyScapeAudioProcessor::getProgramName (int index)
 {
-    // Unused
-    juce::ignoreUnused(index);
-    return {};
+    return presetBank.getPresetName(index);
 }
 
 void HarmonyScapeAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -113,10 +83,32 @@ void HarmonyScapeAudioProcessor::changeProgramName (int index, const juce::Strin
 //==============================================================================
 void HarmonyScapeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Initialize all engines with current sample rate
+    // Restart every random sequence from the saved seed
+    const auto seed = getRandomSeed();
+    spatialEngine.setRandomSeed(seed);
+    ribbonEngine.setRandomSeed(seed);
+    
+    // Initialize all engines with current sample rate and every parameter
+    updateMorph(parameterSnapshot.update());
+    applyParameterChanges(ParameterSnapshot::allGroups);
     chordEngine.prepare(sampleRate, samplesPerBlock);
+    setLatencySamples(chordEngine.getLatencySamples());
     spatialEngine.prepare(sampleRate, samplesPerBlock);
     ribbonEngine.prepare(sampleRate, samplesPerBlock);
+    soundingChord.ensureStorageAllocated(128);
+    
+    presetFade.setCurrentAndTargetValue(1.0f);
+    presetFade.prepare(sampleRate, samplesPerBlock, presetFadeSeconds);
+    
+    // The chord engine dropped its queue, so the passthrough starts over too
+    passthroughMidi.ensureSize(static_cast<size_t>(MAX_DELAYED_MIDI) * 4);
+    delayedMidiHead = 0;
+    numDelayedMidi = 0;
+    passthroughDelay = chordEngine.getLatencySamples();
+    passthroughTime = 0;
+    
+    telemetryInterval = juce::jmax(1, juce::roundToInt(sampleRate / telemetryRateHz));
+    samplesSinceTelemetry = telemetryInterval;
 }
 
 void HarmonyScapeAudioProcessor::releaseResources()
@@ -140,52 +132,78 @@ void HarmonyScapeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     // Clear output buffer
     buffer.clear();
     
-    // Process MIDI messages through chord engine
-    auto chordOutput = chordEngine.processMidi(midiMessages, *chordDensityParam);
+    // Decode the incoming MIDI once; every engine works from these events
+    inputEvents.clear();
+    inputEvents.addMidi(midiMessages, NoteEvent::Source::Input);
+    
+    // MIDI program changes select presets like host program changes do
+    for (const auto metadata : midiMessages)
+        if (metadata.numBytes >= 2 && (metadata.data[0] & 0xf0) == 0xc0)
+            presetBank.selectPreset(metadata.data[1] & 0x7f);
     
-    // Store the chord output in the spatial engine for visualization
-    spatialEngine.setChordOutput(chordOutput);
+    // Parameters are only re-read, and derived state only rebuilt, when they change.
+    // A preset swapped in at the silent point is written over them in this block.
+    auto changedGroups = parameterSnapshot.update();
+    changedGroups |= handlePresetSwitch(changedGroups);
+    changedGroups |= updateMorph(changedGroups);
+    if (changedGroups != 0)
+        applyParameterChanges(changedGroups);
     
-    // Get current chord notes for ribbon processing
-    juce::Array<int> currentChordNotes;
-    for (const auto metadata : chordOutput)
-    {
-        auto message = metadata.getMessage();
-        if (message.isNoteOn())
-        {
-            currentChordNotes.addIfNotAlreadyThere(message.getNoteNumber());
-        }
-    }
+    const auto& params = parameterSnapshot.get();
+    spatialEngine.setWaveformBlend(params.layerBlend.waveform, params.layerBlend.amount);
+    
+    // A selected user style takes over once its file has been compiled
+    if (params.userStyle >= 0 && chordEngine.getStyleLibrary().getNumUserStyles() != knownUserStyles)
+        updateVoicingStyle();
     
-    // Create ribbon parameters structure
-    RibbonEngine::RibbonParams ribbonParams;
-    ribbonParams.enableRibbons = *enableRibbonsParam > 0.5f;
-    ribbonParams.activeRibbons = static_cast<int>(*ribbonCountParam);
-    ribbonParams.globalRate = *ribbonRateParam;
-    ribbonParams.spatialMovement = *ribbonSpreadParam;
+    // Chord engine: the (capture-aligned) input plus the generated harmony
+    noteEvents.clear();
+    chordEngine.processMidi(inputEvents.getEvents(), buffer.getNumSamples(), params.chordDensity, noteEvents);
     
-    // Configure individual ribbons
-    for (int i = 0; i < 3; ++i)
+    // Keep the host's delay compensation in step with the capture window, and the
+    // MIDI passed through in step with what the host compensates
+    if (chordEngine.getLatencySamples() != getLatencySamples())
+        setLatencySamples(chordEngine.getLatencySamples());
+    
+    delayPassthrough(midiMessages, buffer.getNumSamples());
+    
+    trackHeldNotes();
+    
+    // Ribbons play the harmony that is sounding, not just the notes that started
+    // in this block, so they keep running for as long as a chord is held
+    soundingChord.clearQuick();
+    for (int note = 0; note < 128; ++note)
+        if (heldHarmonyNotes[static_cast<size_t>(note)])
+            soundingChord.add(note);
+    
+    // Lock the ribbon clock to the host transport while it plays
+    RibbonEngine::TransportInfo transport;
+    if (auto* hostPlayHead = getPlayHead())
     {
-        ribbonParams.ribbons[i].enabled = *this->ribbonParams[i].enable > 0.5f;
-        ribbonParams.ribbons[i].pattern = static_cast<RibbonEngine::RibbonPattern>(
-            static_cast<int>(*this->ribbonParams[i].pattern));
-        ribbonParams.ribbons[i].rate = *this->ribbonParams[i].rate;
-        ribbonParams.ribbons[i].offset = *this->ribbonParams[i].offset;
-        ribbonParams.ribbons[i].intensity = *ribbonIntensityParam;
-        ribbonParams.ribbons[i].spatialSpread = *ribbonSpreadParam;
+        if (auto position = hostPlayHead->getPosition())
+        {
+            if (auto bpm = position->getBpm())
+                transport.bpm = *bpm;
+            
+            if (auto ppq = position->getPpqPosition())
+            {
+                transport.ppqPosition = *ppq;
+                transport.isPlaying = position->getIsPlaying();
+            }
+        }
     }
     
     // Process ribbons if enabled
-    juce::MidiBuffer ribbonMidi;
-    if (ribbonParams.enableRibbons && !currentChordNotes.isEmpty())
+    if (ribbonSettings.enableRibbons && !soundingChord.isEmpty())
     {
-        auto ribbonNotes = ribbonEngine.processChord(currentChordNotes, ribbonParams, 
-                                                    buffer.getNumSamples(), 120.0);
+        const int numRibbonNotes = ribbonEngine.processChord(soundingChord, ribbonSettings,
+                                                             buffer.getNumSamples(),
+                                                             juce::Span<RibbonEngine::RibbonNote>(ribbonNoteBuffer), transport);
         
-        // Convert ribbon notes to MIDI events with proper timing
-        for (const auto& ribbonNote : ribbonNotes)
+        // Convert ribbon notes to note events with proper timing
+        for (int i = 0; i < numRibbonNotes; ++i)
         {
+            const auto& ribbonNote = ribbonNoteBuffer[static_cast<size_t>(i)];
             if (ribbonNote.active)
             {
                 // Calculate sample position within this buffer based on start time
@@ -195,159 +213,471 @@ void HarmonyScapeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                 // Ribbon note start time relative to current buffer
                 double noteStartSample = ribbonNote.startTime - currentTimeInSamples;
                 
-                // Only add notes that start within this buffer
-                if (noteStartSample >= 0 && noteStartSample < buffer.getNumSamples())
+                // Notes handed over late (after a full block) start at the top of this one
+                if (noteStartSample < buffer.getNumSamples())
                 {
-                    int samplePosition = static_cast<int>(noteStartSample);
+                    int samplePosition = juce::jmax(0, static_cast<int>(noteStartSample));
                     
                     // Use higher velocity for ribbon notes to make them audible
                     float ribbonVelocity = juce::jlimit(0.3f, 1.0f, ribbonNote.velocity * 1.5f);
+                    ribbonVelocity *= ribbonLayerGain[static_cast<size_t>(juce::jlimit(0, RibbonEngine::MAX_RIBBONS - 1,
+                                                                                       ribbonNote.ribbon))];
                     
-                    auto noteOnMsg = juce::MidiMessage::noteOn(1, ribbonNote.midiNote, ribbonVelocity);
-                    ribbonMidi.addEvent(noteOnMsg, samplePosition);
+                    // Fully crossfaded out by a morph
+                    if (ribbonVelocity <= 0.0f)
+                        continue;
+                    
+                    // The ribbon's own stereo placement goes straight to the spatial engine
+                    auto noteOn = NoteEvent::noteOn(samplePosition, 1, ribbonNote.midiNote, ribbonVelocity,
+                                                    NoteEvent::Source::Ribbon, ribbonNote.stepIndex);
+                    noteOn.pan = ribbonNote.spatialPosition;
+                    noteOn.hasPan = true;
+                    noteEvents.add(noteOn);
                     
                     // Calculate note duration in samples (make notes shorter and punchier)
-                    double noteDurationSeconds = 0.1 + (ribbonParams.globalRate * 0.2); // 100-300ms depending on rate
+                    double noteDurationSeconds = 0.1 + (ribbonSettings.globalRate * 0.2); // 100-300ms depending on rate
                     int noteDurationSamples = static_cast<int>(noteDurationSeconds * samplesPerSecond);
                     
-                    // Schedule note off within buffer if duration allows
-                    int noteOffSample = samplePosition + noteDurationSamples;
-                    if (noteOffSample < buffer.getNumSamples())
-                    {
-                        auto noteOffMsg = juce::MidiMessage::noteOff(1, ribbonNote.midiNote);
-                        ribbonMidi.addEvent(noteOffMsg, noteOffSample);
-                    }
+                    // The release is carried across blocks until it falls due
+                    ribbonEngine.scheduleNoteOff(ribbonNote.midiNote, 1,
+                                                 currentTimeInSamples + samplePosition + noteDurationSamples,
+                                                 noteEvents, samplePosition);
                 }
             }
         }
     }
     
+    // Send ribbon releases due in this block, even after the chord or ribbons stop
+    ribbonEngine.renderNoteOffs(noteEvents, buffer.getNumSamples());
+    
     // Advance ribbon engine time
     ribbonEngine.advanceTime(buffer.getNumSamples());
     
-    // Combine all MIDI sources
-    juce::MidiBuffer combinedMidi;
+    // Merge the layers into one sample-ordered stream
+    noteEvents.sort();
     
-    // Add user input MIDI
-    for (const auto metadata : midiMessages)
+    // Apply spatial processing with enhanced parameters
+    spatialEngine.process(buffer, noteEvents.getEvents(), params.spatialWidth, params.waveform,
+                         params.volume, params.spatial, params.rhythm);
+    
+    applyPresetFade(buffer);
+    
+    samplesSinceTelemetry = juce::jmin(samplesSinceTelemetry + buffer.getNumSamples(), telemetryInterval);
+    if (samplesSinceTelemetry >= telemetryInterval && numTelemetryReaders.load(std::memory_order_relaxed) > 0)
     {
-        combinedMidi.addEvent(metadata.getMessage(), metadata.samplePosition);
+        samplesSinceTelemetry = 0;
+        publishTelemetry();
     }
+}
+
+void HarmonyScapeAudioProcessor::delayPassthrough(juce::MidiBuffer& midiMessages, int numSamples)
+{
+    const int delay = chordEngine.getLatencySamples();
     
-    // Add generated chord harmony
-    for (const auto metadata : chordOutput)
+    // No window: the input passes through untouched
+    if (delay == 0 && numDelayedMidi == 0)
     {
-        combinedMidi.addEvent(metadata.getMessage(), metadata.samplePosition);
+        passthroughDelay = 0;
+        passthroughTime += numSamples;
+        return;
     }
     
-    // Add ribbon MIDI
-    for (const auto metadata : ribbonMidi)
+    passthroughMidi.clear();
+    
+    // A new window length: the chord engine releases its queue at the block start, so
+    // does the passthrough
+    if (delay != passthroughDelay)
     {
-        combinedMidi.addEvent(metadata.getMessage(), metadata.samplePosition);
+        releaseDelayedMidi(std::numeric_limits<juce::int64>::max(), true);
+        passthroughDelay = delay;
     }
     
-    // Convert waveform parameter to enum
-    auto waveformType = static_cast<SpatialEngine::WaveformType>(
-        static_cast<int>(*waveformParam));
-    
-    // Create ADSR parameters
-    SpatialEngine::ADSRParams adsr = {
-        *attackParam,
-        *decayParam,
-        *sustainParam,
-        *releaseParam
-    };
-    
-    // Create enhanced spatial parameters
-    SpatialEngine::SpatialParams spatialParams;
-    spatialParams.movementRate = *movementRateParam;
-    spatialParams.movementDepth = *movementDepthParam;
-    spatialParams.height = *heightParam;
-    spatialParams.depth = *depthParam;
-    spatialParams.enableMovement = *enableMovementParam > 0.5f;
-    
-    // Create rhythm parameters
-    SpatialEngine::RhythmParams rhythmParams;
-    rhythmParams.swing = *swingParam;
-    rhythmParams.groove = *grooveParam;
-    rhythmParams.shimmer = *shimmerParam;
-    rhythmParams.shimmerRate = *shimmerRateParam;
-    rhythmParams.enableRhythm = *enableRhythmParam > 0.5f;
+    // Notes exactly as the chord engine played them, capture delay included
+    for (const auto& event : noteEvents)
+    {
+        if (event.source != NoteEvent::Source::Input)
+            continue;
+        
+        passthroughMidi.addEvent(event.isNoteOn ? juce::MidiMessage::noteOn(event.channel, event.noteNumber, event.velocity)
+                                                : juce::MidiMessage::noteOff(event.channel, event.noteNumber),
+                                 event.samplePosition);
+    }
     
-    // Apply spatial processing with enhanced parameters
-    spatialEngine.process(buffer, combinedMidi, *spatialWidthParam, waveformType, 
-                         *volumeParam, adsr, spatialParams, rhythmParams);
+    // Everything else through a delay line of the same length
+    for (const auto metadata : midiMessages)
+    {
+        const int status = metadata.data[0] & 0xf0;
+        if (status == 0x80 || status == 0x90)
+            continue;
+        
+        // System exclusive doesn't fit the queue, and a full queue can't wait: send now
+        if (metadata.numBytes > 3 || numDelayedMidi == MAX_DELAYED_MIDI || delay == 0)
+        {
+            passthroughMidi.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+            continue;
+        }
+        
+        auto& message = delayedMidi[static_cast<size_t>((delayedMidiHead + numDelayedMidi) % MAX_DELAYED_MIDI)];
+        message.dueSample = passthroughTime + metadata.samplePosition + delay;
+        message.numBytes = static_cast<uint8_t>(metadata.numBytes);
+        std::copy(metadata.data, metadata.data + metadata.numBytes, message.data);
+        ++numDelayedMidi;
+    }
     
-    // Get currently sounding notes from the spatial engine
-    updateActiveVoices(spatialEngine.getActiveVoiceNotes());
+    releaseDelayedMidi(passthroughTime + numSamples, false);
+    passthroughTime += numSamples;
+    
+    midiMessages.clear();
+    midiMessages.addEvents(passthroughMidi, 0, -1, 0);
 }
 
-//==============================================================================
-bool HarmonyScapeAudioProcessor::hasEditor() const
+void HarmonyScapeAudioProcessor::releaseDelayedMidi(juce::int64 before, bool atBlockStart)
 {
-    return true;
+    while (numDelayedMidi > 0 && delayedMidi[static_cast<size_t>(delayedMidiHead)].dueSample < before)
+    {
+        const auto& message = delayedMidi[static_cast<size_t>(delayedMidiHead)];
+        const auto samplePosition = atBlockStart ? 0 : juce::jmax(juce::int64(0), message.dueSample - passthroughTime);
+        passthroughMidi.addEvent(message.data, message.numBytes, static_cast<int>(samplePosition));
+        
+        delayedMidiHead = (delayedMidiHead + 1) % MAX_DELAYED_MIDI;
+        --numDelayedMidi;
+    }
 }
 
-juce::AudioProcessorEditor* HarmonyScapeAudioProcessor::createEditor()
+void HarmonyScapeAudioProcessor::trackHeldNotes()
 {
-    return new HarmonyScapeAudioProcessorEditor (*this, parameters);
+    bool changed = false;
+    
+    for (const auto& event : noteEvents)
+    {
+        auto* held = event.source == NoteEvent::Source::Input   ? &heldInputNotesByChannel
+                   : event.source == NoteEvent::Source::Harmony ? &heldHarmonyNotesByChannel
+                                                                 : nullptr;
+        
+        if (held != nullptr && juce::isPositiveAndBelow(event.noteNumber, 128))
+        {
+            (*held)[static_cast<size_t>(event.channel - 1)].set(static_cast<size_t>(event.noteNumber),
+                                                                 event.isNoteOn && event.velocity > 0.0f);
+            changed = true;
+        }
+    }
+    
+    if (!changed)
+        return;
+    
+    // A note is held while any channel holds it
+    heldInputNotes.reset();
+    heldHarmonyNotes.reset();
+    for (size_t channel = 0; channel < heldInputNotesByChannel.size(); ++channel)
+    {
+        heldInputNotes |= heldInputNotesByChannel[channel];
+        heldHarmonyNotes |= heldHarmonyNotesByChannel[channel];
+    }
 }
 
-//==============================================================================
-void HarmonyScapeAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+void HarmonyScapeAudioProcessor::publishTelemetry()
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    auto& state = telemetry.getWriteBuffer();
+    
+    state.userNotes = heldInputNotes;
+    state.generatedNotes = heldHarmonyNotes;
+    
+    state.numVoices = spatialEngine.getVoiceTelemetry(juce::Span<SpatialEngine::VoiceTelemetry>(state.voices));
+    state.soundingNotes.reset();
+    for (int i = 0; i < state.numVoices; ++i)
+        state.soundingNotes.set(static_cast<size_t>(state.voices[static_cast<size_t>(i)].midiNote & 127));
+    
+    state.chordId = chordEngine.getCurrentChordId();
+    
+    state.numRibbons = ribbonSettings.enableRibbons ? ribbonEngine.getNumRunningRibbons() : 0;
+    for (int i = 0; i < state.numRibbons; ++i)
+        state.ribbonSteps[static_cast<size_t>(i)] = ribbonEngine.getCurrentStep(i);
+    
+    telemetry.publish();
 }
 
-void HarmonyScapeAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+uint32_t HarmonyScapeAudioProcessor::handlePresetSwitch(uint32_t changedGroups)
 {
-    std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
+    uint32_t rewritten = 0;
+    
+    // A restored state replaces everything in the snapshot, including a preset
+    // that was cancelled before it reached the parameters
+    if (stateRestored.exchange(false))
+    {
+        parameterSnapshot.reread(ParameterSnapshot::allGroups);
+        rewritten = ParameterSnapshot::allGroups;
+        changedGroups = rewritten;
+    }
     
-    if (xmlState.get() != nullptr)
-        if (xmlState->hasTagName (parameters.state.getType()))
-            parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+    // Until the message thread has copied the last preset into the parameters, groups
+    // re-read from them can still hold the old values; the preset's take precedence
+    if (presetBank.isSyncingParameters() && changedGroups != 0)
+        parameterSnapshot.applyValues(presetValues.data(), changedGroups);
+    
+    if (presetBank.hasPendingPreset())
+    {
+        // Fade out first; once silent, apply the preset to the snapshot and fade
+        // straight back in. Nothing here waits for the message thread.
+        if (presetFade.getTargetValue() > 0.0f)
+        {
+            presetFade.setTargetValue(0.0f);
+        }
+        else if (presetFade.getCurrentValue() <= 0.0f)
+        {
+            if (const auto* preset = presetBank.takePendingPreset())
+            {
+                presetBank.getPlainValues(*preset, presetValues.data());
+                parameterSnapshot.applyValues(presetValues.data(), ParameterSnapshot::allGroups);
+                presetFade.setTargetValue(1.0f);
+                return ParameterSnapshot::allGroups;
+            }
+        }
+    }
+    else if (presetFade.getTargetValue() < 1.0f)
+    {
+        // The request was withdrawn before it could be applied
+        presetFade.setTargetValue(1.0f);
+    }
+    
+    return rewritten;
 }
 
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+void HarmonyScapeAudioProcessor::applyPresetFade(juce::AudioBuffer<float>& buffer)
 {
-    return new HarmonyScapeAudioProcessor();
+    // Nothing to do at unity gain, which is all the time outside a switch
+    if (presetFade.getCurrentValue() >= 1.0f && presetFade.getTargetValue() >= 1.0f)
+        return;
+    
+    const int numSamples = buffer.getNumSamples();
+    
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        const int spanSamples = juce::jmin(numSamples - startSample, presetFade.getMaximumBlockSize());
+        const float* gain = presetFade.getNextBlock(spanSamples);
+        
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, startSample), gain, spanSamples);
+        
+        startSample += spanSamples;
+    }
 }
 
-// Add these methods for keyboard visualization
-juce::Array<int> HarmonyScapeAudioProcessor::getUserInputNotes() const
+uint32_t HarmonyScapeAudioProcessor::updateMorph(uint32_t changedGroups)
 {
-    // Use the spatial engine's tracking
-    return spatialEngine.getUserInputNotes();
+    const auto& params = parameterSnapshot.get();
+    
+    // Slot presets are only converted when a slot changes or a preset finishes loading
+    bool slotsChanged = false;
+    if ((changedGroups & ParameterSnapshot::Morph) != 0 || morphEngine.needsRebuild())
+        slotsChanged = morphEngine.setSlots(params.morphSlots);
+    
+    const bool morphing = params.morphEnabled && morphEngine.isActive();
+    const uint32_t groups = morphing ? morphEngine.getMorphedGroups() : 0;
+    
+    // Groups the morph lets go of return to their parameter values
+    const uint32_t released = morphGroups & ~groups;
+    if (released != 0)
+        parameterSnapshot.reread(released);
+    
+    // Evaluated when the position or the slots move, or when the update above
+    // overwrote a morphed group with its parameter values
+    uint32_t rewritten = released;
+    if (morphing && (slotsChanged || (changedGroups & (groups | ParameterSnapshot::Morph)) != 0
+                     || groups != morphGroups))
+    {
+        morphEngine.evaluate(params.morphPosition);
+        parameterSnapshot.applyValues(morphEngine.getValues(), groups);
+        parameterSnapshot.setLayerBlend(morphEngine.getUpperValues(), morphEngine.getBlendAmount());
+        rewritten |= groups;
+    }
+    else if (!morphing)
+    {
+        parameterSnapshot.setLayerBlend(nullptr, 0.0f);
+    }
+    
+    morphGroups = groups;
+    return rewritten;
 }
 
-juce::Array<int> HarmonyScapeAudioProcessor::getGeneratedNotes() const
+void HarmonyScapeAudioProcessor::applyParameterChanges(uint32_t changedGroups)
 {
-    // Use the spatial engine's tracking
-    return spatialEngine.getGeneratedNotes();
+    const auto& params = parameterSnapshot.get();
+    
+    if ((changedGroups & ParameterSnapshot::Chord) != 0)
+    {
+        // Publish a style only when a style parameter moves
+        if (params.voicingStyle != lastVoicingStyle || params.userStyle != lastUserStyle)
+            updateVoicingStyle();
+        
+        chordEngine.setCaptureWindow(params.captureWindowMs);
+    }
+    
+    // Keyboard split / channel zones
+    if ((changedGroups & ParameterSnapshot::Zones) != 0)
+        updateChordZones();
+    
+    // Envelope rates are derived once per change instead of per sample
+    if ((changedGroups & ParameterSnapshot::Envelope) != 0)
+        spatialEngine.setEnvelope(params.adsr);
+    
+    if ((changedGroups & ParameterSnapshot::Ribbons) != 0)
+        updateRibbonSettings();
 }
 
-// Get notes in release phase that are still sounding
-juce::Array<int> HarmonyScapeAudioProcessor::getReleasingNotes() const
+void HarmonyScapeAudioProcessor::updateRibbonSettings()
 {
-    return releasingNotes;
+    const auto& params = parameterSnapshot.get();
+    
+    ribbonSettings.enableRibbons = params.enableRibbons;
+    ribbonSettings.activeRibbons = params.ribbonCount;
+    ribbonLayerGain.fill(1.0f);
+    ribbonSettings.globalRate = params.ribbonRate;
+    ribbonSettings.spatialMovement = params.ribbonSpread;
+    ribbonSettings.rhythmSync = params.ribbonSync ? 1.0f : 0.0f;
+    
+    // Configure individual ribbons. Ribbons past the ones with their own controls
+    // follow those in turn, each layer shifted by the golden ratio so they interleave.
+    const int numRibbons = juce::jlimit(1, RibbonEngine::MAX_RIBBONS, ribbonSettings.activeRibbons);
+    const int numRibbonParamSets = ParameterSnapshot::NUM_RIBBON_PARAM_SETS;
+    for (int i = 0; i < numRibbons; ++i)
+    {
+        const auto& source = params.ribbons[static_cast<size_t>(i % numRibbonParamSets)];
+        const int layer = i / numRibbonParamSets;
+        auto& ribbon = ribbonSettings.ribbons[static_cast<size_t>(i)];
+        
+        ribbon.enabled = source.enabled;
+        ribbon.pattern = static_cast<RibbonEngine::RibbonPattern>(source.pattern);
+        ribbon.rate = source.rate;
+        ribbon.offset = layer == 0 ? source.offset
+                                   : std::fmod(source.offset + static_cast<float>(layer) * 0.618034f, 1.0f);
+        ribbon.intensity = params.ribbonIntensity;
+        ribbon.spatialSpread = params.ribbonSpread;
+    }
+    
+    // While a morph crossfades patterns, a ribbon whose pattern differs on the far
+    // side gets a twin playing that pattern, and the two share the ribbon's level
+    const auto& blend = params.layerBlend;
+    int numLayers = numRibbons;
+    if (blend.amount > 0.0f)
+    {
+        for (int i = 0; i < numRibbons && numLayers < RibbonEngine::MAX_RIBBONS; ++i)
+        {
+            const auto& ribbon = ribbonSettings.ribbons[static_cast<size_t>(i)];
+            const auto otherPattern = static_cast<RibbonEngine::RibbonPattern>(
+                blend.patterns[static_cast<size_t>(i % numRibbonParamSets)]);
+            if (otherPattern == ribbon.pattern)
+                continue;
+            
+            auto& twin = ribbonSettings.ribbons[static_cast<size_t>(numLayers)];
+            twin = ribbon;
+            twin.pattern = otherPattern;
+            
+            ribbonLayerGain[static_cast<size_t>(i)] = 1.0f - blend.amount;
+            ribbonLayerGain[static_cast<size_t>(numLayers)] = blend.amount;
+            ++numLayers;
+        }
+    }
+    ribbonSettings.activeRibbons = numLayers;
+}
+
+void HarmonyScapeAudioProcessor::updateVoicingStyle()
+{
+    const auto& params = parameterSnapshot.get();
+    auto& library = chordEngine.getStyleLibrary();
+    
+    // Until a selected user style is loaded, the factory style plays
+    knownUserStyles = library.getNumUserStyles();
+    if (params.userStyle < 0 || !library.selectUserStyle(params.userStyle))
+        library.selectFactoryStyle(params.voicingStyle);
+    
+    lastVoicingStyle = params.voicingStyle;
+    lastUserStyle = params.userStyle;
 }
 
-// Update information about which notes are currently audible for visualization
-void HarmonyScapeAudioProcessor::updateActiveVoices(const juce::Array<int>& activeVoiceNotes)
+void HarmonyScapeAudioProcessor::updateChordZones()
 {
-    // Clear the releasing notes array
-    releasingNotes.clearQuick();
+    const auto& params = parameterSnapshot.get();
+    const int zoneMode = params.zoneMode;
+    const int splitPoint = params.splitPoint;
+    const float lowerZoneDensity = params.lowerZoneDensity;
     
-    // For each active voice, check if it's a releasing note (not in userInputNotes or generatedOutputNotes)
-    for (const auto& noteNumber : activeVoiceNotes)
+    for (int i = 0; i < ChordEngine::MAX_ZONES; ++i)
     {
-        if (!spatialEngine.getUserInputNotes().contains(noteNumber) && !spatialEngine.getGeneratedNotes().contains(noteNumber))
+        ChordEngine::ZoneConfig zone;
+        
+        switch (zoneMode)
         {
-            releasingNotes.addIfNotAlreadyThere(noteNumber);
+            case 1: // Split: lower zone with its own density, upper zone follows the global density;
+                    // each voiced on its own channel, so a note both voice is released per zone
+                if (i < 2)
+                {
+                    zone.enabled = true;
+                    zone.lowestNote = (i == 0) ? 0 : splitPoint;
+                    zone.highestNote = (i == 0) ? splitPoint - 1 : 127;
+                    zone.density = (i == 0) ? lowerZoneDensity : -1.0f;
+                    zone.outputChannel = i + 1;
+                }
+                break;
+                
+            case 2: // Per channel: one zone per MIDI channel, voiced back onto that channel
+                zone.enabled = true;
+                zone.midiChannel = i + 1;
+                zone.outputChannel = i + 1;
+                break;
+                
+            default: // Single omni zone
+                zone.enabled = (i == 0);
+                break;
         }
+        
+        // Unchanged zones cost nothing; a density change re-voices the held chord in place
+        chordEngine.setZoneConfig(i, zone);
     }
-} 
\ No newline at end of file
+}
+
+//==============================================================================
+bool HarmonyScapeAudioProcessor::hasEditor() const
+{
+    return true;
+}
+
+juce::AudioProcessorEditor* HarmonyScapeAudioProcessor::createEditor()
+{
+    return new HarmonyScapeAudioProcessorEditor (*this, parameters);
+}
+
+//==============================================================================
+void HarmonyScapeAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    stateSerializer.save (destData);
+}
+
+void HarmonyScapeAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // Hosts often select a program before restoring the state; it mustn't replace it
+    presetBank.cancelPendingPreset();
+    
+    // Older XML states are migrated here and saved in the binary format from then on
+    stateSerializer.load (data, sizeInBytes);
+    
+    // Also replaces any preset the audio thread applied that never reached the parameters
+    stateRestored.store(true);
+}
+
+uint64_t HarmonyScapeAudioProcessor::getRandomSeed() const
+{
+    return static_cast<uint64_t>(static_cast<juce::int64>(
+        parameters.state.getProperty("randomSeed", static_cast<juce::int64>(RealtimeRandom::defaultSeed))));
+}
+
+void HarmonyScapeAudioProcessor::setRandomSeed(uint64_t seed)
+{
+    parameters.state.setProperty("randomSeed", static_cast<juce::int64>(seed), nullptr);
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new HarmonyScapeAudioProcessor();
+}
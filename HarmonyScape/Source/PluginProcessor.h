@@ -4,6 +4,13 @@
 #include "ChordEngine/ChordEngine.h"
 #include "SpatialEngine/SpatialEngine.h"
 #include "RibbonEngine/RibbonEngine.h"
+#include "ParameterSnapshot.h"
+#include "ParameterRamp.h"
+#include "PresetBank.h"
+#include "MorphEngine.h"
+#include "StateSerializer.h"
+#include "EditorTelemetry.h"
+#include "TripleBuffer.h"
 
 //==============================================================================
 /**
@@ -48,26 +55,42 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     //==============================================================================
-    // Get the active user input notes (for visual display)
-    juce::Array<int> getUserInputNotes() const;
+    // Display state for the editor. The audio thread only publishes it while a
+    // reader is attached; readTelemetry() is wait-free and for one reader thread.
+    void attachTelemetryReader() { numTelemetryReaders.fetch_add(1); }
+    void detachTelemetryReader() { numTelemetryReaders.fetch_sub(1); }
+    const EditorTelemetry& readTelemetry() { return telemetry.read(); }
     
-    // Get the generated notes (for visual display)
-    juce::Array<int> getGeneratedNotes() const;
+    // Seed for all randomised engine behaviour, saved with the plugin state.
+    // A new seed takes effect from the next prepareToPlay.
+    uint64_t getRandomSeed() const;
+    void setRandomSeed(uint64_t seed);
     
-    // Get notes that are in release phase but still audible (for keyboard display)
-    juce::Array<int> getReleasingNotes() const;
-    
-    // Update the active voice information from the SpatialEngine
-    void updateActiveVoices(const juce::Array<int>& activeVoiceNotes);
+    // Ribbon note releases that were forced early or dropped (instrumentation)
+    uint32_t getRibbonVoiceLeaks() const { return ribbonEngine.getVoiceLeakCount(); }
 
     // Parameter layout creation
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
     {
         std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
         
         // Existing parameters
         params.push_back(std::make_unique<juce::AudioParameterFloat>(
             "chordDensity", "Chord Density", 0.0f, 1.0f, 0.5f));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+            "voicingStyle", "Voicing Style", FactoryVoicingStyles::getNames(), 0));
+        
+        // Chord zone parameters (keyboard split / per-channel voicing)
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+            "zoneMode", "Zone Mode", juce::StringArray("Single", "Split", "Per Channel"), 0));
+        params.push_back(std::make_unique<juce::AudioParameterInt>(
+            "splitPoint", "Split Point", 0, 127, 60));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+            "lowerZoneDensity", "Lower Zone Density", 0.0f, 1.0f, 0.3f));
+        
+        // Strum capture window in milliseconds (0 = off); reported to the host as latency
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+            "captureWindow", "Strum Capture", juce::NormalisableRange<float>(0.0f, 30.0f, 0.1f), 0.0f));
         params.push_back(std::make_unique<juce::AudioParameterFloat>(
             "spatialWidth", "Spatial Width", 0.0f, 1.0f, 0.5f));
         params.push_back(std::make_unique<juce::AudioParameterChoice>(
@@ -99,7 +122,7 @@ public:
         params.push_back(std::make_unique<juce::AudioParameterBool>(
             "enableRibbons", "Enable Ribbons", true));
         params.push_back(std::make_unique<juce::AudioParameterInt>(
-            "ribbonCount", "Ribbon Count", 1, 5, 2));
+            "ribbonCount", "Ribbon Count", 1, RibbonEngine::MAX_RIBBONS, 2));
         params.push_back(std::make_unique<juce::AudioParameterFloat>(
             "ribbonRate", "Ribbon Rate", 0.0f, 1.0f, 0.5f));
         params.push_back(std::make_unique<juce::AudioParameterFloat>(
@@ -134,6 +157,28 @@ public:
         params.push_back(std::make_unique<juce::AudioParameterBool>(
             "enableRhythm", "Enable Rhythm", true));
 
+        // Preset morph: one macro sweeping across up to four preset slots
+        // (slot values are program numbers from 1, 0 leaves the slot empty)
+        params.push_back(std::make_unique<juce::AudioParameterBool>(
+            "morphEnable", "Morph Enable", false));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+            "morph", "Morph", 0.0f, 1.0f, 0.0f));
+        for (int i = 0; i < ParameterSnapshot::NUM_MORPH_SLOTS; ++i)
+        {
+            params.push_back(std::make_unique<juce::AudioParameterInt>(
+                "morphSlot" + juce::String(i + 1), "Morph Slot " + juce::String(i + 1),
+                0, PresetBank::MAX_PRESETS, i < 2 ? i + 1 : 0));
+        }
+
+        // User voicing style: the n-th style file in the Styles folder by name, in
+        // place of the factory style (0 = none)
+        params.push_back(std::make_unique<juce::AudioParameterInt>(
+            "userStyle", "User Style", 0, VoicingStyleLibrary::MAX_USER_STYLES, 0));
+
+        // Ribbon steps in sixteenths of the host tempo rather than at a free rate
+        params.push_back(std::make_unique<juce::AudioParameterBool>(
+            "ribbonSync", "Ribbon Tempo Sync", false));
+
         return { params.begin(), params.end() };
     }
 
@@ -143,56 +188,112 @@ private:
     SpatialEngine spatialEngine;
     RibbonEngine ribbonEngine;
     
-    // Value tree for plugin state
-    juce::AudioProcessorValueTreeState parameters;
+    // Ribbon notes starting in the current block
+    std::array<RibbonEngine::RibbonNote, RibbonEngine::MAX_SCHEDULED_NOTES> ribbonNoteBuffer;
+    
+    // The held harmony notes, ascending; the chord the ribbons play
+    juce::Array<int> soundingChord;
+    
+    // The block's input notes, decoded once from the incoming MIDI
+    NoteEventBuffer inputEvents;
+    
+    // Every layer's notes for the current block, as handed to the spatial engine
+    NoteEventBuffer noteEvents;
     
-    // Core parameters
-    std::atomic<float>* chordDensityParam = nullptr;
-    std::atomic<float>* spatialWidthParam = nullptr;
-    std::atomic<float>* waveformParam = nullptr;
-    std::atomic<float>* volumeParam = nullptr;
-    
-    // ADSR parameters
-    std::atomic<float>* attackParam = nullptr;
-    std::atomic<float>* decayParam = nullptr;
-    std::atomic<float>* sustainParam = nullptr;
-    std::atomic<float>* releaseParam = nullptr;
-    
-    // Enhanced spatial parameters
-    std::atomic<float>* movementRateParam = nullptr;
-    std::atomic<float>* movementDepthParam = nullptr;
-    std::atomic<float>* heightParam = nullptr;
-    std::atomic<float>* depthParam = nullptr;
-    std::atomic<float>* enableMovementParam = nullptr;
-    
-    // Ribbon parameters
-    std::atomic<float>* enableRibbonsParam = nullptr;
-    std::atomic<float>* ribbonCountParam = nullptr;
-    std::atomic<float>* ribbonRateParam = nullptr;
-    std::atomic<float>* ribbonSpreadParam = nullptr;
-    std::atomic<float>* ribbonIntensityParam = nullptr;
-    
-    // Individual ribbon parameters (first 3 ribbons)
-    struct RibbonParamSet
+    // MIDI passed through to the host, delayed by the capture window like the harmony.
+    // Notes come from the chord engine's aligned input; other short messages wait here.
+    struct DelayedMidi
     {
-        std::atomic<float>* enable = nullptr;
-        std::atomic<float>* pattern = nullptr;
-        std::atomic<float>* rate = nullptr;
-        std::atomic<float>* offset = nullptr;
+        juce::int64 dueSample = 0;
+        uint8_t data[3] {};
+        uint8_t numBytes = 0;
     };
-    std::array<RibbonParamSet, 3> ribbonParams;
-    
-    // Legacy rhythmic parameters
-    std::atomic<float>* swingParam = nullptr;
-    std::atomic<float>* grooveParam = nullptr;
-    std::atomic<float>* shimmerParam = nullptr;
-    std::atomic<float>* shimmerRateParam = nullptr;
-    std::atomic<float>* enableRhythmParam = nullptr;
-    
-    // For keyboard visualization
-    juce::Array<int> userInputNotes;          // Notes actively pressed by user
-    juce::Array<int> generatedOutputNotes;    // Notes generated by chord engine
-    juce::Array<int> releasingNotes;          // Notes in release phase but still sounding
+    static constexpr int MAX_DELAYED_MIDI = 512;
+    std::array<DelayedMidi, MAX_DELAYED_MIDI> delayedMidi;
+    int delayedMidiHead = 0;
+    int numDelayedMidi = 0;
+    int passthroughDelay = 0;                  // Delay of the queued messages, in samples
+    juce::int64 passthroughTime = 0;           // Samples processed, for the due times
+    juce::MidiBuffer passthroughMidi;
+    
+    // Replaces midiMessages with the input delayed by the capture window
+    void delayPassthrough(juce::MidiBuffer& midiMessages, int numSamples);
+    
+    // Moves queued messages due before a sample time into passthroughMidi, at their
+    // due position or all at the block start
+    void releaseDelayedMidi(juce::int64 before, bool atBlockStart);
+    
+    // Value tree for plugin state
+    juce::AudioProcessorValueTreeState parameters;
+    
+    // Audio thread copy of the parameters, refreshed only when one changes
+    ParameterSnapshotManager parameterSnapshot;
+    int lastVoicingStyle = -1;                 // Style parameters last pushed to the chord engine
+    int lastUserStyle = -1;
+    int knownUserStyles = 0;                   // User styles loaded when they were pushed
+    
+    // Ribbon configuration derived from the ribbon parameters
+    RibbonEngine::RibbonParams ribbonSettings;
+    
+    // Velocity scale per ribbon, below 1 while a morph crossfades it with a twin
+    std::array<float, RibbonEngine::MAX_RIBBONS> ribbonLayerGain;
+    
+    // Programs: preset switches dip the output briefly around the parameter swap
+    PresetBank presetBank;
+    static constexpr double presetFadeSeconds = 0.005;
+    ParameterRamp<> presetFade;
+    std::array<float, PresetSnapshot::MAX_PARAMETERS> presetValues {};  // Plain values of the last preset applied
+    std::atomic<bool> stateRestored { false };  // setStateInformation ran; the snapshot is re-read
+    
+    // Fades out, swaps a requested preset into the snapshot, then fades back in.
+    // Returns the groups the preset rewrote.
+    uint32_t handlePresetSwitch(uint32_t changedGroups);
+    void applyPresetFade(juce::AudioBuffer<float>& buffer);
+    
+    // Preset morph, overriding the snapshot groups it morphs while enabled
+    MorphEngine morphEngine;
+    uint32_t morphGroups = 0;                  // Groups the morph currently overrides
+    
+    // Re-evaluates the morph after a snapshot update; returns the groups it rewrote
+    uint32_t updateMorph(uint32_t changedGroups);
+    
+    // Binary plugin state (reads XML states from earlier versions)
+    StateSerializer stateSerializer;
+    
+    // Re-derives engine settings for the parameter groups that changed
+    void applyParameterChanges(uint32_t changedGroups);
+    
+    // Publish the user style if one is selected and loaded, the factory style otherwise
+    void updateVoicingStyle();
+    
+    // Reconfigure chord engine zones from the zone parameters
+    void updateChordZones();
+    
+    // Rebuild ribbonSettings from the ribbon parameters
+    void updateRibbonSettings();
+    
+    // Editor display state, published by the audio thread while an editor is open
+    TripleBuffer<EditorTelemetry> telemetry;
+    std::atomic<int> numTelemetryReaders { 0 };
+    
+    // Published at control rate rather than every block: above any display rate,
+    // and independent of the host's block size
+    static constexpr double telemetryRateHz = 120.0;
+    int telemetryInterval = 400;                 // In samples
+    int samplesSinceTelemetry = 0;
+    EditorTelemetry::NoteSet heldInputNotes;     // Tracked every block, so an editor
+    EditorTelemetry::NoteSet heldHarmonyNotes;   // opened mid-note shows it held
+    
+    // The same per MIDI channel, so a note held on two channels stays held until
+    // both release it
+    std::array<EditorTelemetry::NoteSet, 16> heldInputNotesByChannel;
+    std::array<EditorTelemetry::NoteSet, 16> heldHarmonyNotesByChannel;
+    
+    // Follows the block's note events into the held note sets
+    void trackHeldNotes();
+    
+    // Fills and publishes the telemetry for the block just rendered
+    void publishTelemetry();
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HarmonyScapeAudioProcessor)
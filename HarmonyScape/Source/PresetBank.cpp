@@ -0,0 +1,249 @@
+#include "PresetBank.h"
+
+PresetBank::PresetBank(juce::AudioProcessorValueTreeState& parameters)
+    : processor(parameters.processor)
+{
+    for (auto* parameter : parameters.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parameterList.push_back(ranged);
+
+    jassert(parameterList.size() <= static_cast<size_t>(PresetSnapshot::MAX_PARAMETERS));
+    startTimer(syncIntervalMs);
+}
+
+PresetBank::~PresetBank()
+{
+    // Let any pending load finish before the slots it publishes into go away
+    loader->removeJobs(this);
+    stopTimer();
+}
+
+void PresetBank::loadFactoryPresetsAsync()
+{
+    loader->addJob(this, [this]
+    {
+        for (int i = 0; i < FactoryPresets::NUM_PRESETS; ++i)
+        {
+            const auto& factory = FactoryPresets::presets[static_cast<size_t>(i)];
+
+            auto preset = std::make_unique<PresetSnapshot>();
+            setDefaults(*preset);
+            setName(*preset, factory.name);
+
+            for (const auto& setting : factory.settings)
+            {
+                if (setting.parameterID == nullptr)
+                    break;
+
+                const bool found = setPlainValue(*preset, setting.parameterID, setting.value);
+                jassert(found);
+                juce::ignoreUnused(found);
+            }
+
+            publish(i, std::move(preset));
+        }
+    });
+}
+
+bool PresetBank::loadUserPresetsAsync(const juce::File& directory)
+{
+    if (!directory.isDirectory())
+        return false;
+
+    loader->addJob(this, [this, directory]
+    {
+        auto files = directory.findChildFiles(juce::File::findFiles, false, "*.xml");
+        files.sort();
+
+        for (const auto& file : files)
+        {
+            const int index = FactoryPresets::NUM_PRESETS + numUserPresets.load();
+            if (index >= MAX_PRESETS)
+                break;
+
+            auto xml = juce::parseXML(file);
+            if (xml == nullptr)
+                continue;
+
+            auto preset = std::make_unique<PresetSnapshot>();
+            if (!parsePresetXml(*xml, *preset))
+                continue;
+
+            setName(*preset, xml->getStringAttribute("presetName", file.getFileNameWithoutExtension()));
+            publish(index, std::move(preset));
+            numUserPresets.fetch_add(1);
+
+            // The host is told about the new programs on the message thread
+            presetsAdded.store(true);
+        }
+    });
+
+    return true;
+}
+
+juce::File PresetBank::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile(JucePlugin_Name)
+               .getChildFile("Presets");
+}
+
+juce::String PresetBank::getPresetName(int index) const
+{
+    if (juce::isPositiveAndBelow(index, FactoryPresets::NUM_PRESETS))
+        return FactoryPresets::presets[static_cast<size_t>(index)].name;
+
+    if (juce::isPositiveAndBelow(index, getNumPresets()))
+        if (const auto* preset = slots[static_cast<size_t>(index)].load(std::memory_order_acquire))
+            return preset->name;
+
+    return {};
+}
+
+const PresetSnapshot* PresetBank::getPreset(int index) const noexcept
+{
+    if (!juce::isPositiveAndBelow(index, MAX_PRESETS))
+        return nullptr;
+
+    return slots[static_cast<size_t>(index)].load(std::memory_order_acquire);
+}
+
+void PresetBank::selectPreset(int index) noexcept
+{
+    if (juce::isPositiveAndBelow(index, MAX_PRESETS))
+        pendingPreset.store(index);
+}
+
+void PresetBank::cancelPendingPreset() noexcept
+{
+    pendingPreset.store(-1);
+    presetToSync.store(nullptr, std::memory_order_release);
+}
+
+bool PresetBank::hasPendingPreset() const noexcept
+{
+    const int index = pendingPreset.load();
+    return index >= 0 && slots[static_cast<size_t>(index)].load(std::memory_order_acquire) != nullptr;
+}
+
+const PresetSnapshot* PresetBank::takePendingPreset() noexcept
+{
+    int index = pendingPreset.load();
+    if (index < 0)
+        return nullptr;
+
+    // Not loaded yet: the request stays pending until it is
+    const auto* preset = slots[static_cast<size_t>(index)].load(std::memory_order_acquire);
+    if (preset == nullptr)
+        return nullptr;
+
+    // Handed to the message thread before the request is cleared, so a cancel in
+    // between drops both. A newer request arriving in between is left for the
+    // next call, and the preset before this one goes back to being synced.
+    const auto* previous = presetToSync.exchange(preset, std::memory_order_acq_rel);
+    if (!pendingPreset.compare_exchange_strong(index, -1))
+    {
+        presetToSync.compare_exchange_strong(preset, previous, std::memory_order_acq_rel);
+        return nullptr;
+    }
+
+    currentPreset.store(index);
+    return preset;
+}
+
+void PresetBank::getPlainValues(const PresetSnapshot& preset, float* plainValues) const noexcept
+{
+    for (size_t i = 0; i < parameterList.size(); ++i)
+    {
+        const auto* parameter = parameterList[i];
+        const float value = i < static_cast<size_t>(preset.numValues) ? preset.values[i] : parameter->getDefaultValue();
+        plainValues[i] = parameter->convertFrom0to1(value);
+    }
+}
+
+void PresetBank::timerCallback()
+{
+    if (presetsAdded.exchange(false))
+        processor.updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+
+    if (const auto* preset = presetToSync.load(std::memory_order_acquire))
+    {
+        apply(*preset);
+        
+        // A preset taken while this one was copied is copied on the next tick
+        presetToSync.compare_exchange_strong(preset, nullptr, std::memory_order_acq_rel);
+    }
+}
+
+void PresetBank::apply(const PresetSnapshot& preset)
+{
+    const auto numValues = juce::jmin(static_cast<size_t>(preset.numValues), parameterList.size());
+
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        auto* parameter = parameterList[i];
+        const float value = preset.values[i];
+
+        // Unchanged parameters are skipped so their listeners and the host stay quiet
+        if (std::abs(parameter->getValue() - value) > 1.0e-6f)
+            parameter->setValueNotifyingHost(value);
+    }
+}
+
+bool PresetBank::parsePresetXml(const juce::XmlElement& xml, PresetSnapshot& preset) const
+{
+    setDefaults(preset);
+    setName(preset, xml.getStringAttribute("presetName"));
+
+    bool foundAny = false;
+    for (auto* child : xml.getChildWithTagNameIterator("PARAM"))
+    {
+        foundAny |= setPlainValue(preset, child->getStringAttribute("id"),
+                                  static_cast<float>(child->getDoubleAttribute("value")));
+    }
+
+    return foundAny;
+}
+
+void PresetBank::setDefaults(PresetSnapshot& preset) const
+{
+    preset.numValues = static_cast<int>(juce::jmin(parameterList.size(),
+                                                   static_cast<size_t>(PresetSnapshot::MAX_PARAMETERS)));
+
+    for (int i = 0; i < preset.numValues; ++i)
+        preset.values[static_cast<size_t>(i)] = parameterList[static_cast<size_t>(i)]->getDefaultValue();
+}
+
+bool PresetBank::setPlainValue(PresetSnapshot& preset, const juce::String& parameterID, float plainValue) const
+{
+    for (int i = 0; i < preset.numValues; ++i)
+    {
+        const auto* parameter = parameterList[static_cast<size_t>(i)];
+        if (parameter->getParameterID() == parameterID)
+        {
+            const auto& range = parameter->getNormalisableRange();
+            const float clamped = juce::jlimit(range.start, range.end, plainValue);
+            preset.values[static_cast<size_t>(i)] = parameter->convertTo0to1(clamped);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PresetBank::setName(PresetSnapshot& preset, const juce::String& name)
+{
+    name.copyToUTF8(preset.name, sizeof(preset.name));
+}
+
+void PresetBank::publish(int index, std::unique_ptr<PresetSnapshot> preset)
+{
+    const PresetSnapshot* published = preset.get();
+
+    {
+        const juce::ScopedLock lock(snapshotsLock);
+        snapshots.add(preset.release());
+    }
+
+    slots[static_cast<size_t>(index)].store(published, std::memory_order_release);
+}
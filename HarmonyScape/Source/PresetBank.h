@@ -0,0 +1,212 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "BackgroundLoader.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * A preset in the form the audio thread applies it: the normalised value of
+ * every parameter, in the order of the processor's parameter list.
+ */
+struct PresetSnapshot
+{
+    static constexpr int MAX_PARAMETERS = 64;
+    static constexpr int MAX_NAME_LENGTH = 32;
+
+    char name[MAX_NAME_LENGTH] {};
+    int numValues = 0;
+    std::array<float, MAX_PARAMETERS> values {};
+};
+
+/**
+ * A factory preset as data. It lists the parameters it changes, as plain (not
+ * normalised) values; every other parameter takes its default.
+ */
+struct FactoryPreset
+{
+    static constexpr int MAX_SETTINGS = 12;
+
+    struct Setting
+    {
+        const char* parameterID = nullptr;
+        float value = 0.0f;
+    };
+
+    const char* name = "";
+    std::array<Setting, MAX_SETTINGS> settings {};
+};
+
+/**
+ * Factory presets, in program order.
+ */
+struct FactoryPresets
+{
+    static constexpr int NUM_PRESETS = 20;
+
+    static constexpr std::array<FactoryPreset, NUM_PRESETS> presets {{
+        { "Init", {} },
+        { "Warm Pad", {{ { "chordDensity", 0.6f }, { "attack", 0.8f }, { "decay", 0.6f }, { "sustain", 0.8f },
+                         { "release", 1.2f }, { "spatialWidth", 0.7f }, { "enableRibbons", 0.0f } }} },
+        { "Jazz Club", {{ { "voicingStyle", 1.0f }, { "chordDensity", 0.7f }, { "waveform", 3.0f },
+                          { "attack", 0.02f }, { "release", 0.4f }, { "spatialWidth", 0.4f },
+                          { "enableRibbons", 0.0f }, { "swing", 0.3f } }} },
+        { "Neo-Soul Keys", {{ { "voicingStyle", 2.0f }, { "chordDensity", 0.8f }, { "waveform", 3.0f },
+                              { "attack", 0.01f }, { "decay", 0.4f }, { "sustain", 0.5f }, { "release", 0.5f },
+                              { "groove", 0.3f } }} },
+        { "Cinematic Swell", {{ { "voicingStyle", 3.0f }, { "chordDensity", 0.6f }, { "waveform", 1.0f },
+                                { "attack", 1.5f }, { "sustain", 0.9f }, { "release", 2.0f },
+                                { "spatialWidth", 0.9f }, { "movementDepth", 0.5f } }} },
+        { "Wide Strings", {{ { "waveform", 1.0f }, { "attack", 0.4f }, { "sustain", 0.8f }, { "release", 0.9f },
+                             { "spatialWidth", 1.0f }, { "movementRate", 0.2f }, { "enableRibbons", 0.0f } }} },
+        { "Glass Arps", {{ { "ribbonCount", 3.0f }, { "ribbonRate", 0.7f }, { "ribbonSpread", 0.9f },
+                           { "ribbon3Enable", 1.0f }, { "attack", 0.005f }, { "decay", 0.2f },
+                           { "sustain", 0.3f }, { "release", 0.6f }, { "shimmer", 0.4f } }} },
+        { "Cascade Rain", {{ { "ribbonCount", 8.0f }, { "ribbonRate", 0.8f }, { "ribbonIntensity", 0.6f },
+                             { "ribbon1Pattern", 5.0f }, { "ribbon2Pattern", 5.0f }, { "ribbon3Pattern", 1.0f },
+                             { "ribbon3Enable", 1.0f }, { "sustain", 0.4f }, { "release", 0.8f } }} },
+        { "Spiral Motion", {{ { "ribbonCount", 4.0f }, { "ribbon1Pattern", 6.0f }, { "ribbon2Pattern", 6.0f },
+                              { "ribbonSpread", 1.0f }, { "movementRate", 0.7f }, { "movementDepth", 0.6f } }} },
+        { "Lo-Fi Square", {{ { "waveform", 2.0f }, { "volume", 0.5f }, { "chordDensity", 0.4f },
+                             { "spatialWidth", 0.3f }, { "enableMovement", 0.0f }, { "groove", 0.4f } }} },
+        { "Saw Ensemble", {{ { "waveform", 1.0f }, { "chordDensity", 0.9f }, { "volume", 0.55f },
+                             { "attack", 0.1f }, { "release", 0.5f }, { "spatialWidth", 0.8f } }} },
+        { "Split Bass & Chords", {{ { "zoneMode", 1.0f }, { "splitPoint", 52.0f }, { "lowerZoneDensity", 0.1f },
+                                    { "chordDensity", 0.6f }, { "enableRibbons", 0.0f } }} },
+        { "Strummed Guitar", {{ { "captureWindow", 25.0f }, { "waveform", 3.0f }, { "attack", 0.003f },
+                                { "decay", 0.5f }, { "sustain", 0.2f }, { "release", 0.3f },
+                                { "enableRibbons", 0.0f } }} },
+        { "Ambient Drift", {{ { "voicingStyle", 3.0f }, { "attack", 2.0f }, { "release", 2.0f },
+                              { "sustain", 1.0f }, { "ribbonRate", 0.2f }, { "movementRate", 0.1f },
+                              { "movementDepth", 0.8f }, { "spatialWidth", 1.0f } }} },
+        { "Pluck Sequence", {{ { "ribbonCount", 2.0f }, { "ribbonRate", 0.9f }, { "attack", 0.001f },
+                               { "decay", 0.15f }, { "sustain", 0.0f }, { "release", 0.1f } }} },
+        { "Dense Cluster", {{ { "chordDensity", 1.0f }, { "voicingStyle", 2.0f }, { "volume", 0.5f },
+                              { "spatialWidth", 0.9f }, { "enableRibbons", 0.0f } }} },
+        { "Sparse Triads", {{ { "chordDensity", 0.1f }, { "waveform", 0.0f }, { "spatialWidth", 0.5f },
+                              { "enableRibbons", 0.0f } }} },
+        { "Shimmer Field", {{ { "shimmer", 0.8f }, { "shimmerRate", 0.7f }, { "ribbonCount", 6.0f },
+                              { "ribbonIntensity", 0.5f }, { "attack", 0.3f }, { "release", 1.5f } }} },
+        { "Tight Stabs", {{ { "attack", 0.001f }, { "decay", 0.08f }, { "sustain", 0.0f }, { "release", 0.05f },
+                            { "waveform", 1.0f }, { "enableRibbons", 0.0f }, { "spatialWidth", 0.3f } }} },
+        { "Per-Channel Choir", {{ { "zoneMode", 2.0f }, { "chordDensity", 0.5f }, { "attack", 0.3f },
+                                  { "sustain", 0.9f }, { "release", 0.8f }, { "enableRibbons", 0.0f } }} },
+    }};
+};
+
+/**
+ * PresetBank holds every preset as a ready-to-apply PresetSnapshot.
+ *
+ * Factory tables and user preset files (the plugin's state XML) are turned into
+ * snapshots on a background thread and published into fixed slots with atomic
+ * pointer stores. Selecting a preset only records its index; the audio thread
+ * picks the request up when it is ready to switch and applies the snapshot's
+ * values itself. A timer on the message thread then copies them into the
+ * parameters, so the host and the editor show the preset. The audio thread never
+ * parses, locks, allocates, waits or calls into the host for a switch.
+ *
+ * Snapshots stay alive for the lifetime of the bank, so a pointer the audio
+ * thread has loaded can never dangle.
+ */
+class PresetBank : private juce::Timer
+{
+public:
+    static constexpr int MAX_PRESETS = 128;
+
+    explicit PresetBank(juce::AudioProcessorValueTreeState& parameters);
+    ~PresetBank() override;
+
+    /** Builds the factory snapshots in the background. */
+    void loadFactoryPresetsAsync();
+
+    /**
+     * Parses the .xml presets in a directory in the background, appending them
+     * after the factory presets. Returns false if the directory doesn't exist.
+     */
+    bool loadUserPresetsAsync(const juce::File& directory);
+
+    /** Where user presets are looked for by default */
+    static juce::File getUserPresetDirectory();
+
+    /** Factory presets plus the user presets loaded so far */
+    int getNumPresets() const noexcept { return FactoryPresets::NUM_PRESETS + numUserPresets.load(); }
+
+    juce::String getPresetName(int index) const;
+
+    /** Any thread: a preset's snapshot, or nullptr if it isn't loaded (yet). Wait-free. */
+    const PresetSnapshot* getPreset(int index) const noexcept;
+
+    /** Any thread: asks for a preset to be applied. The latest request wins. */
+    void selectPreset(int index) noexcept;
+
+    /**
+     * Drops a requested preset that hasn't been applied, and one the audio thread
+     * has applied but that hasn't been copied into the parameters yet. Called
+     * before restoring a state, so a program selected earlier can't overwrite it.
+     */
+    void cancelPendingPreset() noexcept;
+
+    /** The preset last applied, or -1 if none has been */
+    int getCurrentPreset() const noexcept { return currentPreset.load(); }
+
+    /** Audio thread: whether a requested preset is loaded and waiting to be applied */
+    bool hasPendingPreset() const noexcept;
+
+    /**
+     * Audio thread: the requested preset, if it is loaded, clearing the request.
+     * Wait-free. The caller applies its values; the message thread copies them
+     * into the parameters shortly after, and until it has, isSyncingParameters()
+     * returns true.
+     */
+    const PresetSnapshot* takePendingPreset() noexcept;
+
+    /** Whether a taken preset is still to be copied into the parameters */
+    bool isSyncingParameters() const noexcept { return presetToSync.load(std::memory_order_acquire) != nullptr; }
+
+    /**
+     * Audio thread: a snapshot's values as plain values, indexed like the
+     * processor's parameters (as ParameterSnapshotManager::applyValues takes them)
+     */
+    void getPlainValues(const PresetSnapshot& preset, float* plainValues) const noexcept;
+
+    /** Message thread: sets every parameter the snapshot differs in, notifying the host */
+    void apply(const PresetSnapshot& preset);
+
+    /**
+     * Fills a snapshot from state XML (PARAM children with id and plain value).
+     * Parameters it doesn't mention keep their defaults. Returns false if no
+     * parameter was recognised.
+     */
+    bool parsePresetXml(const juce::XmlElement& xml, PresetSnapshot& preset) const;
+
+private:
+    void setDefaults(PresetSnapshot& preset) const;
+    bool setPlainValue(PresetSnapshot& preset, const juce::String& parameterID, float plainValue) const;
+    static void setName(PresetSnapshot& preset, const juce::String& name);
+    void publish(int index, std::unique_ptr<PresetSnapshot> preset);
+    void timerCallback() override;
+
+    // How often the message thread looks for presets to copy into the parameters
+    static constexpr int syncIntervalMs = 20;
+
+    // Told when loading in the background changes the number of presets
+    juce::AudioProcessor& processor;
+
+    // Parameters in processor order (immutable after construction)
+    std::vector<juce::RangedAudioParameter*> parameterList;
+
+    std::array<std::atomic<const PresetSnapshot*>, MAX_PRESETS> slots {};
+    std::atomic<int> numUserPresets { 0 };
+    std::atomic<int> pendingPreset { -1 };
+    std::atomic<int> currentPreset { -1 };
+    std::atomic<const PresetSnapshot*> presetToSync { nullptr };
+    std::atomic<bool> presetsAdded { false };
+
+    // Background parsing, on the loader thread shared by all instances
+    juce::SharedResourcePointer<BackgroundLoader> loader;
+    juce::CriticalSection snapshotsLock;
+    juce::OwnedArray<PresetSnapshot> snapshots;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
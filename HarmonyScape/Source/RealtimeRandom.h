@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Seedable, allocation-free random number generator for the audio thread
+ * (xoshiro128**, seeded through splitmix64).
+ *
+ * Everything randomised in the engines draws from one of these, so the same seed
+ * and the same input reproduce the same output exactly, for offline renders and
+ * regression tests alike. It never touches the OS entropy source.
+ *
+ * Each engine uses its own stream of a shared seed, so engines don't disturb
+ * each other's sequences.
+ */
+class RealtimeRandom
+{
+public:
+    static constexpr uint64_t defaultSeed = 0x4861726d6f6e7953ull;  // "HarmonyS"
+
+    explicit RealtimeRandom(uint64_t seed = defaultSeed, uint32_t stream = 0) noexcept
+    {
+        setSeed(seed, stream);
+    }
+
+    /** Restarts the sequence for a seed and stream. */
+    void setSeed(uint64_t seed, uint32_t stream = 0) noexcept
+    {
+        uint64_t mix = seed ^ (static_cast<uint64_t>(stream) * 0x9e3779b97f4a7c15ull);
+
+        for (auto& word : state)
+        {
+            // splitmix64
+            mix += 0x9e3779b97f4a7c15ull;
+            uint64_t z = mix;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = static_cast<uint32_t>(z ^ (z >> 31));
+        }
+
+        // The all-zero state is the one state xoshiro can't leave
+        if ((state[0] | state[1] | state[2] | state[3]) == 0)
+            state[0] = 1;
+    }
+
+    /** Next 32 random bits. */
+    uint32_t next() noexcept
+    {
+        const uint32_t result = rotl(state[1] * 5, 7) * 9;
+        const uint32_t t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    /** Uniform float in [0, 1). */
+    float nextFloat() noexcept
+    {
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /** Uniform float in [-1, 1). */
+    float nextBipolar() noexcept
+    {
+        return nextFloat() * 2.0f - 1.0f;
+    }
+
+    /** Uniform integer in [0, maxExclusive); 0 if maxExclusive <= 0. */
+    int nextInt(int maxExclusive) noexcept
+    {
+        if (maxExclusive <= 0)
+            return 0;
+
+        // Multiply-shift range reduction; the bias is negligible for the small ranges used here
+        return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(maxExclusive)) >> 32);
+    }
+
+    /** Fisher-Yates shuffle of the first numItems items (same result on every platform). */
+    template <typename Item>
+    void shuffle(Item* items, int numItems) noexcept
+    {
+        for (int i = numItems - 1; i > 0; --i)
+        {
+            const int j = nextInt(i + 1);
+            const Item temp = items[i];
+            items[i] = items[j];
+            items[j] = temp;
+        }
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) noexcept
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    uint32_t state[4] {};
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <vector>
+
+/**
+ * One message-thread timer that refreshes every open editor in the process, so
+ * several plugin instances update in the same tick instead of each waking the
+ * message thread on its own.
+ *
+ * A client is refreshed at the full frame rate while it reports activity, and for
+ * a short hold afterwards so a release or a drag doesn't flicker between rates;
+ * otherwise only at the idle rate. The timer itself slows to the idle rate once
+ * no client is active.
+ *
+ * Share it with a juce::SharedResourcePointer<RefreshScheduler>; it only runs
+ * while it has clients.
+ */
+class RefreshScheduler : private juce::Timer
+{
+public:
+    static constexpr int frameRateHz = 60;
+    static constexpr int idleRateHz = 10;
+    static constexpr double activeHoldMs = 500.0;
+
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Updates the display; returns true while there is activity worth full frame rate */
+        virtual bool refresh() = 0;
+    };
+
+    ~RefreshScheduler() override { stopTimer(); }
+
+    /** Starts refreshing client; it counts as active at first, so it fills in promptly */
+    void addClient(Client& client)
+    {
+        clients.push_back({ &client, 0.0, juce::Time::getMillisecondCounterHiRes() + activeHoldMs });
+        setRate(frameRateHz);
+    }
+
+    void removeClient(Client& client)
+    {
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [&client](const Entry& entry) { return entry.client == &client; }),
+                      clients.end());
+
+        if (clients.empty())
+            stopTimer();
+    }
+
+private:
+    struct Entry
+    {
+        Client* client;
+        double lastRefreshMs;
+        double activeUntilMs;
+    };
+
+    void timerCallback() override
+    {
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        // Half a frame of slack, so timer jitter doesn't push an idle refresh a whole tick late
+        const double idleIntervalMs = 1000.0 / idleRateHz - 500.0 / frameRateHz;
+
+        bool anyActive = false;
+        for (auto& entry : clients)
+        {
+            if (now < entry.activeUntilMs || now - entry.lastRefreshMs >= idleIntervalMs)
+            {
+                entry.lastRefreshMs = now;
+                if (entry.client->refresh())
+                    entry.activeUntilMs = now + activeHoldMs;
+            }
+
+            anyActive |= now < entry.activeUntilMs;
+        }
+
+        setRate(anyActive ? frameRateHz : idleRateHz);
+    }
+
+    void setRate(int rateHz)
+    {
+        // Restarting the timer resets its phase, so only do it when the rate changes
+        if (!isTimerRunning() || getTimerInterval() != 1000 / rateHz)
+            startTimerHz(rateHz);
+    }
+
+    std::vector<Entry> clients;
+};
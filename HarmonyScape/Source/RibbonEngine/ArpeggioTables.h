@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Arpeggio orderings with a fixed permutation (Random is shuffled at runtime instead)
+ */
+enum class ArpeggioOrdering : uint8_t
+{
+    Up,
+    Down,
+    Outside,        // From the middle outward
+    Inside,         // From the edges inward, starting low
+    Cascade,        // Even positions, then odd positions
+    SpiralFromHigh, // Edges inward, starting high (Spiral from low equals Inside)
+    NumOrderings
+};
+
+/**
+ * Generates the arpeggio permutation tables at compile time.
+ *
+ * For every ordering and chord size (1 to MAX_CHORD_SIZE), the table lists which
+ * note of the ascending-sorted chord is played at each step.
+ */
+struct ArpeggioTableBuilder
+{
+    static constexpr int MAX_CHORD_SIZE = 16;
+    static constexpr int NumOrderings = static_cast<int>(ArpeggioOrdering::NumOrderings);
+
+    using Permutation = std::array<uint8_t, MAX_CHORD_SIZE>;
+    using Table = std::array<std::array<Permutation, MAX_CHORD_SIZE + 1>, NumOrderings>;
+
+    static constexpr Permutation build(ArpeggioOrdering ordering, int size)
+    {
+        Permutation order {};
+        size_t count = 0;
+
+        switch (ordering)
+        {
+            case ArpeggioOrdering::Up:
+                for (int i = 0; i < size; ++i)
+                    order[count++] = static_cast<uint8_t>(i);
+                break;
+
+            case ArpeggioOrdering::Down:
+                for (int i = size - 1; i >= 0; --i)
+                    order[count++] = static_cast<uint8_t>(i);
+                break;
+
+            case ArpeggioOrdering::Outside:
+            {
+                const int mid = size / 2;
+                if (size % 2 == 1)
+                {
+                    order[count++] = static_cast<uint8_t>(mid);
+                    for (int i = 1; i <= mid; ++i)
+                    {
+                        order[count++] = static_cast<uint8_t>(mid + i);
+                        order[count++] = static_cast<uint8_t>(mid - i);
+                    }
+                }
+                else
+                {
+                    for (int i = 0; i < mid; ++i)
+                    {
+                        order[count++] = static_cast<uint8_t>(mid + i);
+                        order[count++] = static_cast<uint8_t>(mid - 1 - i);
+                    }
+                }
+                break;
+            }
+
+            case ArpeggioOrdering::Inside:
+            case ArpeggioOrdering::SpiralFromHigh:
+            {
+                int left = 0, right = size - 1;
+                bool fromLeft = ordering == ArpeggioOrdering::Inside;
+                while (left <= right)
+                {
+                    order[count++] = static_cast<uint8_t>(fromLeft ? left++ : right--);
+                    fromLeft = !fromLeft;
+                }
+                break;
+            }
+
+            case ArpeggioOrdering::Cascade:
+                for (int wave = 0; wave < 2; ++wave)
+                    for (int i = 0; i < size; ++i)
+                        if ((i + wave) % 2 == 0)
+                            order[count++] = static_cast<uint8_t>(i);
+                break;
+
+            case ArpeggioOrdering::NumOrderings:
+            default:
+                break;
+        }
+
+        return order;
+    }
+
+    static constexpr Table buildAll()
+    {
+        Table table {};
+        for (int ordering = 0; ordering < NumOrderings; ++ordering)
+            for (int size = 1; size <= MAX_CHORD_SIZE; ++size)
+                table[static_cast<size_t>(ordering)][static_cast<size_t>(size)] = build(static_cast<ArpeggioOrdering>(ordering), size);
+        return table;
+    }
+};
+
+/**
+ * Read-only access to the arpeggio permutations. Building a ribbon sequence is a
+ * sort of the chord plus a gather through the table.
+ */
+struct ArpeggioTables
+{
+    static constexpr int MAX_CHORD_SIZE = ArpeggioTableBuilder::MAX_CHORD_SIZE;
+
+    /** Step-to-sorted-index permutation for an ordering and chord size (1 to MAX_CHORD_SIZE). */
+    static constexpr const ArpeggioTableBuilder::Permutation& get(ArpeggioOrdering ordering, int size)
+    {
+        return table[static_cast<size_t>(ordering)][static_cast<size_t>(size)];
+    }
+
+    static constexpr ArpeggioTableBuilder::Table table = ArpeggioTableBuilder::buildAll();
+};
@@ -1,16 +1,9 @@
 #include "RibbonEngine.h"
-#include <random>
 
 RibbonEngine::RibbonEngine()
 {
-    // Initialize default ribbon configurations
-    for (int i = 0; i < MAX_RIBBONS; ++i)
-    {
-        auto& ribbon = ribbonStates[i].sequence;
-        ribbon.clear();
-        ribbonStates[i].active = false;
-        ribbonStates[i].phase = i * 0.2; // Offset each ribbon slightly
-    }
+    // No ribbon is running until its first block
+    ribbonStates.nextStepBeat.fill(std::numeric_limits<double>::infinity());
 }
 
 RibbonEngine::~RibbonEngine()
@@ -22,222 +15,241 @@ void RibbonEngine::prepare(double newSampleRate, int newSamplesPerBlock)
     sampleRate = newSampleRate;
     samplesPerBlock = newSamplesPerBlock;
     currentSamplePosition = 0.0;
+    random.setSeed(randomSeed.load(), randomStream);
+    
+    // Room for every MIDI note, so taking a new chord never reallocates
+    currentChordNotes.ensureStorageAllocated(128);
 }
 
-juce::Array<RibbonEngine::RibbonNote> RibbonEngine::processChord(const juce::Array<int>& chordNotes,
-                                                                const RibbonParams& ribbonParams,
-                                                                int numSamples,
-                                                                double hostTempo)
+int RibbonEngine::processChord(const juce::Array<int>& chordNotes,
+                               const RibbonParams& ribbonParams,
+                               int numSamples,
+                               juce::Span<RibbonNote> dueNotes,
+                               const TransportInfo& transport)
 {
     if (!ribbonParams.enableRibbons || chordNotes.isEmpty())
     {
-        return {};
+        return 0;
     }
     
-    // Clear old scheduled notes that have passed
-    scheduledNotes.removeIf([this](const RibbonNote& note) {
-        return note.startTime + note.duration < currentSamplePosition;
-    });
-    
     // Update current chord if it has changed
     if (currentChordNotes != chordNotes)
     {
         setCurrentChord(chordNotes);
     }
     
-    // Process each active ribbon
-    int activeCount = juce::jlimit(1, MAX_RIBBONS, ribbonParams.activeRibbons);
+    // This block's beat range on the ribbon clock
+    const double bpm = transport.bpm > 0.0 ? transport.bpm : 120.0;
+    const double samplesPerBeat = beatsToSamples(1.0, bpm);
+    double beatStart = transport.isPlaying ? transport.ppqPosition : freeRunningBeats;
+    const double beatEnd = beatStart + samplesToBeats(numSamples, bpm);
+    freeRunningTempo = bpm;
     
+    // Hosts report PPQ with rounding error; a position just behind the previous
+    // block's end continues from there instead of repeating a step. Larger jumps
+    // (loops, relocation) are followed as they are.
+    const bool contiguous = lastClockBeatEnd >= 0.0 && std::abs(beatStart - lastClockBeatEnd) < 1.0e-6;
+    if (contiguous)
+        beatStart = lastClockBeatEnd;
+    
+    lastClockBeatEnd = beatEnd;
+    
+    const int activeCount = juce::jlimit(1, MAX_RIBBONS, ribbonParams.activeRibbons);
+    const bool sync = ribbonParams.rhythmSync >= 0.5f;
+    auto& states = ribbonStates;
+    
+    // Ribbons keep their next step from the previous block; they are only
+    // rescheduled when their timing changes or the clock jumps
     for (int i = 0; i < activeCount; ++i)
     {
-        if (ribbonParams.ribbons[i].enabled)
-        {
-            updateRibbonPhase(i, ribbonParams.ribbons[i], chordNotes, numSamples);
-        }
+        const auto& config = ribbonParams.ribbons[static_cast<size_t>(i)];
+        const double stepLength = config.enabled ? calculateStepLength(config, ribbonParams.globalRate, bpm, sync)
+                                                 : 0.0;
+        const double offset = config.offset;
+        
+        // Timing that hasn't moved beyond rounding keeps the ribbon's schedule
+        if (contiguous && std::abs(stepLength - states.stepLength[static_cast<size_t>(i)]) < 1.0e-6
+            && std::abs(offset - states.stepOffset[static_cast<size_t>(i)]) < 1.0e-6)
+            continue;
+        
+        states.stepLength[static_cast<size_t>(i)] = stepLength;
+        states.stepOffset[static_cast<size_t>(i)] = offset;
+        scheduleNextStep(i, beatStart);
+    }
+    
+    // Ribbons dropped from the count stop, and start afresh when they return
+    for (int i = activeCount; i < numScheduledRibbons; ++i)
+    {
+        states.stepLength[static_cast<size_t>(i)] = 0.0;
+        states.nextStepBeat[static_cast<size_t>(i)] = std::numeric_limits<double>::infinity();
     }
+    numScheduledRibbons = activeCount;
     
-    // Return notes that should be active in this block
-    juce::Array<RibbonNote> activeNotes;
-    for (const auto& note : scheduledNotes)
+    // Branch-free scan for the ribbons with a step in this block (vectorises)
+    for (int i = 0; i < activeCount; ++i)
+        states.due[static_cast<size_t>(i)] = static_cast<uint8_t>(states.nextStepBeat[static_cast<size_t>(i)] < beatEnd);
+    
+    // Only ribbons that emit a note do any further work
+    for (int i = 0; i < activeCount; ++i)
     {
-        if (note.startTime <= currentSamplePosition + numSamples &&
-            note.startTime + note.duration >= currentSamplePosition)
-        {
-            activeNotes.add(note);
-        }
+        if (states.due[static_cast<size_t>(i)] != 0)
+            emitRibbonSteps(i, ribbonParams.ribbons[static_cast<size_t>(i)], chordNotes,
+                            beatStart, beatEnd, samplesPerBeat);
     }
     
-    return activeNotes;
+    // Pop only the notes starting in this block
+    const double blockEnd = currentSamplePosition + numSamples;
+    int numDue = 0;
+    
+    while (!scheduledNotes.isEmpty() && scheduledNotes.topTime() < blockEnd
+           && numDue < static_cast<int>(dueNotes.size()))
+    {
+        const auto note = scheduledNotes.pop();
+        
+        // Notes that would already have finished (e.g. queued while ribbons were idle) are dropped
+        if (note.startTime + note.duration < currentSamplePosition)
+            continue;
+        
+        dueNotes[static_cast<size_t>(numDue++)] = note;
+    }
+    
+    return numDue;
 }
 
 void RibbonEngine::advanceTime(int numSamples)
 {
     currentSamplePosition += numSamples;
+    
+    // The free-running clock keeps going while no chord is held
+    freeRunningBeats += samplesToBeats(numSamples, freeRunningTempo);
 }
 
-juce::Array<RibbonEngine::RibbonNote> RibbonEngine::getActiveNotes(int samplePosition) const
+void RibbonEngine::scheduleNoteOff(int midiNote, int channel, double releaseTime,
+                                   NoteEventBuffer& noteOutput, int samplePosition)
 {
-    juce::Array<RibbonNote> activeNotes;
+    if (midiNote < 0 || midiNote > 127)
+        return;
     
-    for (const auto& note : scheduledNotes)
+    // Queue full: bring the earliest release forward rather than lose a note-off
+    if (pendingNoteOffs.isFull())
     {
-        if (note.startTime <= currentSamplePosition + samplePosition &&
-            note.startTime + note.duration >= currentSamplePosition + samplePosition)
-        {
-            activeNotes.add(note);
-        }
+        releaseNote(pendingNoteOffs.pop(), noteOutput, samplePosition);
+        voiceLeaks.fetch_add(1, std::memory_order_relaxed);
     }
     
-    return activeNotes;
+    if (heldNoteCounts[static_cast<size_t>(midiNote)]++ == 0)
+        ++numHeldNotes;
+    
+    PendingNoteOff noteOff;
+    noteOff.time = releaseTime;
+    noteOff.midiNote = midiNote;
+    noteOff.channel = channel;
+    pendingNoteOffs.push(noteOff);
 }
 
-void RibbonEngine::reset()
+void RibbonEngine::renderNoteOffs(NoteEventBuffer& noteOutput, int numSamples)
 {
-    currentSamplePosition = 0.0;
-    scheduledNotes.clear();
+    const double blockEnd = currentSamplePosition + numSamples;
     
-    for (auto& state : ribbonStates)
+    while (!pendingNoteOffs.isEmpty() && pendingNoteOffs.topTime() < blockEnd)
     {
-        state.phase = 0.0;
-        state.currentStep = 0;
-        state.lastEventTime = 0.0;
-        state.active = false;
+        const auto noteOff = pendingNoteOffs.pop();
+        const int samplePosition = juce::jlimit(0, juce::jmax(0, numSamples - 1),
+                                                static_cast<int>(noteOff.time - currentSamplePosition));
+        releaseNote(noteOff, noteOutput, samplePosition);
     }
 }
 
-void RibbonEngine::setCurrentChord(const juce::Array<int>& chordNotes)
+void RibbonEngine::releaseNote(const PendingNoteOff& noteOff, NoteEventBuffer& noteOutput, int samplePosition)
 {
-    currentChordNotes = chordNotes;
+    auto& count = heldNoteCounts[static_cast<size_t>(noteOff.midiNote)];
+    if (count == 0)
+        return;
     
-    // Regenerate sequences for all ribbons when chord changes
-    for (int i = 0; i < MAX_RIBBONS; ++i)
+    if (--count == 0)
     {
-        // Use default pattern for now - this could be configurable
-        RibbonPattern pattern = static_cast<RibbonPattern>(i % 7);
-        ribbonStates[i].sequence = generateArpeggiationSequence(chordNotes, pattern, i);
-        ribbonStates[i].currentStep = 0;
+        --numHeldNotes;
+        noteOutput.add(NoteEvent::noteOff(samplePosition, noteOff.channel, noteOff.midiNote, NoteEvent::Source::Ribbon));
     }
 }
 
-juce::Array<int> RibbonEngine::generateArpeggiationSequence(const juce::Array<int>& chordNotes,
-                                                           RibbonPattern pattern,
-                                                           int ribbonIndex)
+void RibbonEngine::reset()
+{
+    currentSamplePosition = 0.0;
+    random.setSeed(randomSeed.load(), randomStream);
+    freeRunningBeats = 0.0;
+    lastClockBeatEnd = -1.0;
+    scheduledNotes.clear();
+    
+    // Nothing can be sent from here, so held ribbon notes are abandoned
+    voiceLeaks.fetch_add(static_cast<uint32_t>(numHeldNotes), std::memory_order_relaxed);
+    pendingNoteOffs.clear();
+    heldNoteCounts.fill(0);
+    numHeldNotes = 0;
+    
+    // Every ribbon is rescheduled on the next block
+    ribbonStates.stepLength.fill(0.0);
+    ribbonStates.nextStepBeat.fill(std::numeric_limits<double>::infinity());
+    ribbonStates.due.fill(0);
+    ribbonStates.phase.fill(0.0);
+    ribbonStates.currentStep.fill(0);
+    ribbonStates.sequenceLength.fill(0);
+}
+
+void RibbonEngine::setCurrentChord(const juce::Array<int>& chordNotes)
+{
+    // Copied element by element into the storage reserved in prepare
+    currentChordNotes.clearQuick();
+    for (int i = 0; i < juce::jmin(chordNotes.size(), 128); ++i)
+        currentChordNotes.add(chordNotes.getUnchecked(i));
+    
+    // Sequences are regenerated from each ribbon's pattern when it next steps,
+    // so idle ribbons cost nothing on a chord change
+    ribbonStates.sequenceLength.fill(0);
+}
+
+int RibbonEngine::generateArpeggiationSequence(const juce::Array<int>& chordNotes,
+                                               RibbonPattern pattern,
+                                               int ribbonIndex,
+                                               std::array<int, MAX_SEQUENCE_LENGTH>& sequence)
 {
     if (chordNotes.isEmpty())
-        return {};
+        return 0;
+    
+    // Sort into a fixed array; chords beyond the table size keep their lowest notes
+    std::array<int, 128> sortedNotes;
+    const int numNotes = juce::jmin(chordNotes.size(), static_cast<int>(sortedNotes.size()));
+    std::copy(chordNotes.begin(), chordNotes.begin() + numNotes, sortedNotes.begin());
+    std::sort(sortedNotes.begin(), sortedNotes.begin() + numNotes);
     
-    juce::Array<int> sequence;
-    auto sortedNotes = chordNotes;
+    const int size = juce::jmin(numNotes, MAX_SEQUENCE_LENGTH);
     
+    ArpeggioOrdering ordering = ArpeggioOrdering::Up;
     switch (pattern)
     {
-        case RibbonPattern::Up:
-            sortedNotes.sort();
-            sequence = sortedNotes;
-            break;
-            
-        case RibbonPattern::Down:
-            sortedNotes.sort();
-            for (int i = sortedNotes.size() - 1; i >= 0; --i)
-                sequence.add(sortedNotes[i]);
-            break;
-            
-        case RibbonPattern::Outside:
-            {
-                sortedNotes.sort();
-                int mid = sortedNotes.size() / 2;
-                
-                // Start from middle and work outward
-                if (sortedNotes.size() % 2 == 1)
-                {
-                    sequence.add(sortedNotes[mid]);
-                    for (int i = 1; i <= mid; ++i)
-                    {
-                        if (mid + i < sortedNotes.size())
-                            sequence.add(sortedNotes[mid + i]);
-                        if (mid - i >= 0)
-                            sequence.add(sortedNotes[mid - i]);
-                    }
-                }
-                else
-                {
-                    for (int i = 0; i < mid; ++i)
-                    {
-                        sequence.add(sortedNotes[mid + i]);
-                        sequence.add(sortedNotes[mid - 1 - i]);
-                    }
-                }
-            }
-            break;
-            
-        case RibbonPattern::Inside:
-            {
-                sortedNotes.sort();
-                int left = 0, right = sortedNotes.size() - 1;
-                bool addFromLeft = true;
-                
-                while (left <= right)
-                {
-                    if (addFromLeft)
-                        sequence.add(sortedNotes[left++]);
-                    else
-                        sequence.add(sortedNotes[right--]);
-                    addFromLeft = !addFromLeft;
-                }
-            }
-            break;
-            
-        case RibbonPattern::Random:
-            {
-                sequence = sortedNotes;
-                std::random_device rd;
-                std::mt19937 g(rd() + ribbonIndex); // Add ribbon index for consistency
-                std::shuffle(sequence.begin(), sequence.end(), g);
-            }
-            break;
-            
-        case RibbonPattern::Cascade:
-            {
-                sortedNotes.sort();
-                // Create overlapping waves
-                for (int wave = 0; wave < 2; ++wave)
-                {
-                    for (int i = 0; i < sortedNotes.size(); ++i)
-                    {
-                        if ((i + wave) % 2 == 0) // Offset for each wave
-                            sequence.add(sortedNotes[i]);
-                    }
-                }
-            }
-            break;
-            
-        case RibbonPattern::Spiral:
-            {
-                sortedNotes.sort();
-                // Alternate between low and high, spiraling inward
-                juce::Array<int> temp = sortedNotes;
-                bool fromLow = (ribbonIndex % 2 == 0);
-                
-                while (!temp.isEmpty())
-                {
-                    if (fromLow)
-                    {
-                        sequence.add(temp.removeAndReturn(0));
-                    }
-                    else
-                    {
-                        sequence.add(temp.removeAndReturn(temp.size() - 1));
-                    }
-                    fromLow = !fromLow;
-                }
-            }
+        case RibbonPattern::Up:      ordering = ArpeggioOrdering::Up; break;
+        case RibbonPattern::Down:    ordering = ArpeggioOrdering::Down; break;
+        case RibbonPattern::Outside: ordering = ArpeggioOrdering::Outside; break;
+        case RibbonPattern::Inside:  ordering = ArpeggioOrdering::Inside; break;
+        case RibbonPattern::Random:  ordering = ArpeggioOrdering::Up; break;
+        case RibbonPattern::Cascade: ordering = ArpeggioOrdering::Cascade; break;
+        case RibbonPattern::Spiral:  // Alternate between low and high, spiraling inward
+            ordering = (ribbonIndex % 2 == 0) ? ArpeggioOrdering::Inside : ArpeggioOrdering::SpiralFromHigh;
             break;
     }
     
-    return sequence;
+    // Gather through the precomputed permutation
+    const auto& permutation = ArpeggioTables::get(ordering, size);
+    for (int i = 0; i < size; ++i)
+        sequence[static_cast<size_t>(i)] = sortedNotes[permutation[static_cast<size_t>(i)]];
+    
+    if (pattern == RibbonPattern::Random)
+        random.shuffle(sequence.data(), size);
+    
+    return size;
 }
 
-float RibbonEngine::calculateRibbonSpatialPosition(int noteIndex, int totalNotes, 
+float RibbonEngine::calculateRibbonSpatialPosition(int ribbonIndex, int noteIndex, int totalNotes, 
                                                   const RibbonConfig& config,
                                                   float globalSpatialMovement)
 {
@@ -251,92 +263,113 @@ float RibbonEngine::calculateRibbonSpatialPosition(int noteIndex, int totalNotes
     basePosition *= config.spatialSpread;
     
     // Add movement based on ribbon phase and global spatial movement
-    float movement = std::sin(ribbonStates[0].phase * 2.0f * juce::MathConstants<float>::pi) 
+    float movement = std::sin(ribbonStates.phase[static_cast<size_t>(ribbonIndex)] * 2.0f * juce::MathConstants<float>::pi) 
                     * globalSpatialMovement * 0.3f;
     
     // Ensure we stay within bounds
     return juce::jlimit(-1.0f, 1.0f, basePosition + movement);
 }
 
-double RibbonEngine::calculateNoteStartTime(int stepIndex, const RibbonConfig& config,
-                                           float globalRate, double hostTempo, bool sync)
+double RibbonEngine::calculateStepLength(const RibbonConfig& config, float globalRate,
+                                         double hostTempo, bool sync) const
 {
     // Base timing calculation
-    double stepDuration;
+    double beatsPerStep;
     
-    if (sync && hostTempo > 0.0)
+    if (sync)
     {
         // Sync to host tempo - use 16th notes as base
-        double beatsPerStep = 0.25 * (1.0f - globalRate * 0.8f); // Faster rate = shorter notes
-        stepDuration = beatsToSamples(beatsPerStep, hostTempo);
+        beatsPerStep = 0.25 * (1.0f - globalRate * 0.8f); // Faster rate = shorter notes
     }
     else
     {
         // Free-running mode
         double rateHz = 1.0 + globalRate * 10.0; // 1-11 Hz range
-        stepDuration = sampleRate / rateHz;
+        beatsPerStep = samplesToBeats(sampleRate / rateHz, hostTempo);
     }
     
     // Apply individual ribbon rate scaling
-    stepDuration *= (2.0f - config.rate); // rate 0=slow, 1=fast
+    beatsPerStep *= (2.0f - config.rate); // rate 0=slow, 1=fast
     
-    // Add offset for this ribbon
-    double offset = config.offset * stepDuration;
+    return juce::jmax(1.0e-3, beatsPerStep);
+}
+
+void RibbonEngine::scheduleNextStep(int ribbonIndex, double beatStart)
+{
+    auto& states = ribbonStates;
+    const auto index = static_cast<size_t>(ribbonIndex);
+    const double stepLength = states.stepLength[index];
     
-    return currentSamplePosition + stepIndex * stepDuration + offset;
+    if (stepLength <= 0.0)
+    {
+        states.nextStepBeat[index] = std::numeric_limits<double>::infinity();
+        return;
+    }
+    
+    // Step k sits at (k + offset) * stepLength on the clock
+    const double offset = states.stepOffset[index];
+    auto step = static_cast<juce::int64>(std::ceil(beatStart / stepLength - offset));
+    
+    // Settle rounding so the first step is decided by the same expression as the emission loop
+    while ((static_cast<double>(step - 1) + offset) * stepLength >= beatStart)
+        --step;
+    while ((static_cast<double>(step) + offset) * stepLength < beatStart)
+        ++step;
+    
+    states.nextStep[index] = step;
+    states.nextStepBeat[index] = (static_cast<double>(step) + offset) * stepLength;
 }
 
-void RibbonEngine::updateRibbonPhase(int ribbonIndex, const RibbonConfig& config,
-                                    const juce::Array<int>& chordNotes, int numSamples)
+void RibbonEngine::emitRibbonSteps(int ribbonIndex, const RibbonConfig& config,
+                                   const juce::Array<int>& chordNotes,
+                                   double beatStart, double beatEnd, double samplesPerBeat)
 {
-    auto& state = ribbonStates[ribbonIndex];
+    auto& states = ribbonStates;
+    const auto index = static_cast<size_t>(ribbonIndex);
+    auto& sequence = states.sequences[index];
     
-    if (state.sequence.isEmpty())
+    if (states.sequenceLength[index] == 0)
     {
-        state.sequence = generateArpeggiationSequence(chordNotes, config.pattern, ribbonIndex);
-        if (state.sequence.isEmpty())
+        states.sequenceLength[index] = generateArpeggiationSequence(chordNotes, config.pattern, ribbonIndex, sequence);
+        if (states.sequenceLength[index] == 0)
             return;
     }
     
-    // Calculate how fast this ribbon should progress
-    double rateMultiplier = config.rate * 2.0; // 0-2x speed
-    double phaseIncrement = (static_cast<double>(numSamples) / sampleRate) * rateMultiplier;
-    
-    state.phase += phaseIncrement;
+    const int stepsPerCycle = states.sequenceLength[index];
+    const double stepLength = states.stepLength[index];
+    const double offset = states.stepOffset[index];
+    auto step = states.nextStep[index];
     
-    // Check if we should trigger new notes
-    int stepsPerCycle = state.sequence.size();
-    if (stepsPerCycle > 0)
+    for (double stepBeat = states.nextStepBeat[index];
+         stepBeat < beatEnd;
+         stepBeat = (static_cast<double>(++step) + offset) * stepLength)
     {
-        double stepPhase = state.phase * stepsPerCycle;
-        int currentStepInPhase = static_cast<int>(stepPhase) % stepsPerCycle;
+        // The step number picks the note, so a relocated transport lands on the same pattern position
+        const int stepInCycle = static_cast<int>(((step % stepsPerCycle) + stepsPerCycle) % stepsPerCycle);
+        states.currentStep[index] = stepInCycle;
+        states.phase[index] = static_cast<double>(step) / stepsPerCycle;
         
-        // If we've moved to a new step, schedule a note
-        if (currentStepInPhase != state.currentStep || 
-            (state.phase > state.lastEventTime + 1.0 / stepsPerCycle))
-        {
-            state.currentStep = currentStepInPhase;
-            state.lastEventTime = state.phase;
-            
-            // Create a new ribbon note
-            RibbonNote newNote;
-            newNote.midiNote = state.sequence[currentStepInPhase];
-            newNote.ribbon = ribbonIndex;
-            newNote.startTime = currentSamplePosition;
-            newNote.duration = sampleRate / (4.0 + config.rate * 8.0); // Variable duration
-            newNote.velocity = config.intensity;
-            newNote.spatialPosition = calculateRibbonSpatialPosition(
-                currentStepInPhase, stepsPerCycle, config, 0.5f);
-            newNote.active = true;
-            newNote.stepIndex = currentStepInPhase;
-            
-            // Apply decay based on step position
-            float decayFactor = std::pow(config.decay, currentStepInPhase);
-            newNote.velocity *= decayFactor;
-            
-            scheduledNotes.add(newNote);
-        }
+        // Create a new ribbon note
+        RibbonNote newNote;
+        newNote.midiNote = sequence[static_cast<size_t>(stepInCycle)];
+        newNote.ribbon = ribbonIndex;
+        newNote.startTime = currentSamplePosition + (stepBeat - beatStart) * samplesPerBeat;
+        newNote.duration = sampleRate / (4.0 + config.rate * 8.0); // Variable duration
+        newNote.velocity = config.intensity;
+        newNote.spatialPosition = calculateRibbonSpatialPosition(
+            ribbonIndex, stepInCycle, stepsPerCycle, config, 0.5f);
+        newNote.active = true;
+        newNote.stepIndex = stepInCycle;
+        
+        // Apply decay based on step position
+        float decayFactor = std::pow(config.decay, stepInCycle);
+        newNote.velocity *= decayFactor;
+        
+        scheduledNotes.push(newNote);
     }
+    
+    states.nextStep[index] = step;
+    states.nextStepBeat[index] = (static_cast<double>(step) + offset) * stepLength;
 }
 
 double RibbonEngine::beatsToSamples(double beats, double bpm) const
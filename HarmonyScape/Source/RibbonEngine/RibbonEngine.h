@@ -1,17 +1,27 @@
 #pragma once
 
 #include "../JuceHeader.h"
+#include "../NoteEvent.h"
+#include "ScheduledEventQueue.h"
+#include "ArpeggioTables.h"
+#include "../RealtimeRandom.h"
 #include <array>
+#include <atomic>
+#include <limits>
 
 /**
  * RibbonEngine handles rhythmic arpeggiations that ripple forward in space and time.
- * It creates up to 5 "ribbons" (rhythmic patterns) that can be applied to chord clusters.
+ * It creates up to 64 "ribbons" (rhythmic patterns) that can be applied to chord clusters.
+ *
+ * Ribbon state is kept as parallel arrays. Each ribbon remembers its next step
+ * boundary, so a block only scans those boundaries and does real work for the
+ * ribbons that actually emit a note.
  */
 class RibbonEngine
 {
 public:
     // Maximum number of ribbons supported
-    static constexpr int MAX_RIBBONS = 5;
+    static constexpr int MAX_RIBBONS = 64;
     
     // Ribbon pattern types
     enum class RibbonPattern
@@ -40,7 +50,7 @@ public:
     // Global ribbon parameters
     struct RibbonParams
     {
-        int activeRibbons = 1;      // Number of active ribbons (1-5)
+        int activeRibbons = 1;      // Number of active ribbons (1-64)
         float globalRate = 0.5f;    // Master rate control
         float spatialMovement = 0.3f; // How much ribbons affect spatial positioning
         float rhythmSync = 0.0f;    // Sync to host tempo (0=free, 1=sync)
@@ -49,6 +59,14 @@ public:
         std::array<RibbonConfig, MAX_RIBBONS> ribbons;
     };
     
+    // Host transport driving the ribbon clock
+    struct TransportInfo
+    {
+        double bpm = 120.0;
+        double ppqPosition = 0.0;   // Host position in quarter notes at the block start
+        bool isPlaying = false;     // When false the ribbon clock runs freely at bpm
+    };
+    
     // Ribbon note event for scheduling
     struct RibbonNote
     {
@@ -70,18 +88,24 @@ public:
      */
     void prepare(double sampleRate, int samplesPerBlock);
     
+    // Maximum number of ribbon notes waiting to start
+    static constexpr int MAX_SCHEDULED_NOTES = 1024;
+    
     /**
      * Process a chord cluster and generate rhythmic ribbon patterns
      * @param chordNotes Array of MIDI notes representing the chord
      * @param ribbonParams Configuration for ribbon behavior
      * @param numSamples Number of samples in this processing block
-     * @param hostTempo Current host tempo (BPM) for sync
-     * @return Array of RibbonNote events to be triggered
+     * @param dueNotes Receives the notes starting in this block, in start order
+     * @param transport Host tempo and position; steps lock to the host's PPQ while it plays
+     * @return Number of notes written to dueNotes. If it fills up, the remaining
+     *         due notes are returned by the next call.
      */
-    juce::Array<RibbonNote> processChord(const juce::Array<int>& chordNotes,
-                                        const RibbonParams& ribbonParams,
-                                        int numSamples,
-                                        double hostTempo = 120.0);
+    int processChord(const juce::Array<int>& chordNotes,
+                     const RibbonParams& ribbonParams,
+                     int numSamples,
+                     juce::Span<RibbonNote> dueNotes,
+                     const TransportInfo& transport);
     
     /**
      * Update internal timing and generate note events for this block
@@ -89,15 +113,68 @@ public:
     void advanceTime(int numSamples);
     
     /**
-     * Get currently active ribbon notes for this sample position
+     * Number of ribbon notes scheduled but not yet started
+     */
+    int getNumScheduledNotes() const { return scheduledNotes.size(); }
+    
+    // Maximum number of ribbon note releases waiting to be sent
+    static constexpr int MAX_PENDING_NOTE_OFFS = 1024;
+    
+    /**
+     * Schedules the release of a ribbon note that has just been started. Releases
+     * are carried across blocks until they fall due. A pitch retriggered before its
+     * release only gets its note-off once its last pending release falls due. If
+     * the queue is full, the earliest release is sent now to make room and counted
+     * as a voice leak.
+     * @param midiNote Note that was started
+     * @param channel MIDI channel of the note
+     * @param releaseTime Absolute time of the release (in samples)
+     * @param noteOutput Receives a forced early release
+     * @param samplePosition Position in the current block for a forced release
+     */
+    void scheduleNoteOff(int midiNote, int channel, double releaseTime,
+                         NoteEventBuffer& noteOutput, int samplePosition);
+    
+    /**
+     * Adds the releases falling due in this block at their exact sample positions.
+     * Call once per block, before advanceTime, whether or not ribbons are playing.
      */
-    juce::Array<RibbonNote> getActiveNotes(int samplePosition) const;
+    void renderNoteOffs(NoteEventBuffer& noteOutput, int numSamples);
+    
+    /**
+     * Releases that couldn't be delivered on time: forced early on queue overflow,
+     * or dropped by reset() while the note was still held
+     */
+    uint32_t getVoiceLeakCount() const { return voiceLeaks.load(std::memory_order_relaxed); }
+    
+    /**
+     * Number of pitches currently held by ribbon notes
+     */
+    int getNumHeldNotes() const { return numHeldNotes; }
+    
+    /**
+     * Number of ribbons the last block ran, for display
+     */
+    int getNumRunningRibbons() const { return numScheduledRibbons; }
+    
+    /**
+     * Sequence step a ribbon played last, for display
+     */
+    int getCurrentStep(int ribbonIndex) const
+    {
+        return ribbonStates.currentStep[static_cast<size_t>(juce::jlimit(0, MAX_RIBBONS - 1, ribbonIndex))];
+    }
     
     /**
      * Reset all ribbon state (e.g., when transport stops)
      */
     void reset();
     
+    /**
+     * Seed for random patterns. Takes effect on the next prepare() or reset().
+     */
+    void setRandomSeed(uint64_t seed) { randomSeed.store(seed); }
+    
     /**
      * Set the current chord for ribbon processing
      */
@@ -109,54 +186,102 @@ public:
     double getCurrentTime() const { return currentSamplePosition; }
 
 private:
+    // Longest arpeggio sequence; larger chords keep their lowest notes
+    static constexpr int MAX_SEQUENCE_LENGTH = ArpeggioTables::MAX_CHORD_SIZE;
+    
     /**
      * Generate arpeggiation sequence for a ribbon pattern
+     * @param sequence Receives up to MAX_SEQUENCE_LENGTH notes
+     * @return Number of notes in the sequence
      */
-    juce::Array<int> generateArpeggiationSequence(const juce::Array<int>& chordNotes,
-                                                  RibbonPattern pattern,
-                                                  int ribbonIndex);
+    int generateArpeggiationSequence(const juce::Array<int>& chordNotes,
+                                     RibbonPattern pattern,
+                                     int ribbonIndex,
+                                     std::array<int, MAX_SEQUENCE_LENGTH>& sequence);
     
     /**
-     * Calculate spatial position for a note in a ribbon
+     * Calculate spatial position for a note in a ribbon, moving with that ribbon's phase
      */
-    float calculateRibbonSpatialPosition(int noteIndex, int totalNotes, 
+    float calculateRibbonSpatialPosition(int ribbonIndex, int noteIndex, int totalNotes, 
                                        const RibbonConfig& config,
                                        float globalSpatialMovement);
     
     /**
-     * Calculate timing for ribbon note events
+     * Length of one ribbon step in beats
      */
-    double calculateNoteStartTime(int stepIndex, const RibbonConfig& config,
-                                 float globalRate, double hostTempo, bool sync);
+    double calculateStepLength(const RibbonConfig& config, float globalRate,
+                               double hostTempo, bool sync) const;
     
     /**
-     * Update ribbon phase and generate new events
+     * Finds a ribbon's first step boundary at or after beatStart. Only needed when
+     * its timing changes or the clock jumps; otherwise the next step carries over.
      */
-    void updateRibbonPhase(int ribbonIndex, const RibbonConfig& config,
-                          const juce::Array<int>& chordNotes, int numSamples);
+    void scheduleNextStep(int ribbonIndex, double beatStart);
+    
+    /**
+     * Schedules every step of a ribbon from its next step up to beatEnd, in O(steps)
+     */
+    void emitRibbonSteps(int ribbonIndex, const RibbonConfig& config,
+                         const juce::Array<int>& chordNotes,
+                         double beatStart, double beatEnd, double samplesPerBeat);
 
     // Engine state
     double sampleRate = 44100.0;
     int samplesPerBlock = 512;
     double currentSamplePosition = 0.0;
     
-    // Current chord being processed
+    // Current chord being processed (storage reserved in prepare)
     juce::Array<int> currentChordNotes;
     
-    // Ribbon state
-    struct RibbonState
+    // Ribbon state, one array per field so the per-block scan is a tight loop
+    struct RibbonStates
     {
-        double phase = 0.0;              // Current phase in pattern
-        int currentStep = 0;             // Current step in sequence
-        juce::Array<int> sequence;       // Current arpeggiation sequence
-        double lastEventTime = 0.0;      // When last note was triggered
-        bool active = false;
+        std::array<double, MAX_RIBBONS> stepLength {};      // Step length in beats (0 = not running)
+        std::array<double, MAX_RIBBONS> stepOffset {};      // Phase offset in steps
+        std::array<double, MAX_RIBBONS> nextStepBeat {};    // Clock position of the next step
+        std::array<juce::int64, MAX_RIBBONS> nextStep {};   // Number of the next step
+        std::array<uint8_t, MAX_RIBBONS> due {};            // Next step falls in the current block
+        std::array<double, MAX_RIBBONS> phase {};           // Current phase in pattern (cycles)
+        std::array<int, MAX_RIBBONS> currentStep {};        // Current step in sequence
+        std::array<int, MAX_RIBBONS> sequenceLength {};     // 0 = regenerate before the next step
+        std::array<std::array<int, MAX_SEQUENCE_LENGTH>, MAX_RIBBONS> sequences {};
     };
     
-    std::array<RibbonState, MAX_RIBBONS> ribbonStates;
+    RibbonStates ribbonStates;
+    int numScheduledRibbons = 0;         // Ribbons covered by the last block
+    
+    // Ribbon clock in beats: follows the host PPQ while it plays, otherwise runs freely
+    double freeRunningBeats = 0.0;
+    double freeRunningTempo = 120.0;
+    double lastClockBeatEnd = -1.0;      // End of the previous block's beat range
     
-    // Scheduled note events
-    juce::Array<RibbonNote> scheduledNotes;
+    // Deterministic randomness (Random pattern shuffles)
+    static constexpr uint32_t randomStream = 1;
+    std::atomic<uint64_t> randomSeed { RealtimeRandom::defaultSeed };
+    RealtimeRandom random;
+    
+    // Scheduled note events, earliest start first
+    ScheduledEventQueue<RibbonNote, &RibbonNote::startTime, MAX_SCHEDULED_NOTES> scheduledNotes;
+    
+    // Pending releases, earliest first
+    struct PendingNoteOff
+    {
+        double time = 0.0;          // Absolute release time (in samples)
+        int midiNote = 60;
+        int channel = 1;
+    };
+    
+    ScheduledEventQueue<PendingNoteOff, &PendingNoteOff::time, MAX_PENDING_NOTE_OFFS> pendingNoteOffs;
+    
+    // Outstanding releases per pitch; the note-off is sent when it drops to zero
+    std::array<uint16_t, 128> heldNoteCounts {};
+    int numHeldNotes = 0;
+    std::atomic<uint32_t> voiceLeaks { 0 };
+    
+    /**
+     * Counts down a pitch and sends its note-off when no releases remain
+     */
+    void releaseNote(const PendingNoteOff& noteOff, NoteEventBuffer& noteOutput, int samplePosition);
     
     // Timing utilities
     double beatsToSamples(double beats, double bpm) const;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+
+/**
+ * Fixed-capacity priority queue of timed events (binary min-heap on the event's
+ * time member). Pushing and popping are O(log n); finding what is due in a block
+ * only touches the events that are actually due. Storage is inline, so nothing
+ * is allocated after construction.
+ *
+ * @tparam Event       Copyable event type
+ * @tparam timeMember  Member holding the event time (in samples)
+ * @tparam Capacity    Maximum number of pending events
+ */
+template <typename Event, double Event::* timeMember, int Capacity>
+class ScheduledEventQueue
+{
+public:
+    bool isEmpty() const noexcept { return numEvents == 0; }
+    bool isFull() const noexcept { return numEvents == Capacity; }
+    int size() const noexcept { return numEvents; }
+
+    void clear() noexcept { numEvents = 0; }
+
+    /** The earliest event; only valid if the queue isn't empty. */
+    const Event& top() const noexcept { return events[0]; }
+
+    /** Time of the earliest event; only valid if the queue isn't empty. */
+    double topTime() const noexcept { return events[0].*timeMember; }
+
+    /** Adds an event. Returns false (and drops the event) if the queue is full. */
+    bool push(const Event& event) noexcept
+    {
+        if (numEvents == Capacity)
+            return false;
+
+        // Sift up
+        int index = numEvents++;
+        while (index > 0)
+        {
+            const int parent = (index - 1) / 2;
+            if (events[static_cast<size_t>(parent)].*timeMember <= event.*timeMember)
+                break;
+
+            events[static_cast<size_t>(index)] = events[static_cast<size_t>(parent)];
+            index = parent;
+        }
+
+        events[static_cast<size_t>(index)] = event;
+        return true;
+    }
+
+    /** Removes and returns the earliest event; only valid if the queue isn't empty. */
+    Event pop() noexcept
+    {
+        const Event earliest = events[0];
+        const Event last = events[static_cast<size_t>(--numEvents)];
+
+        // Sift the last event down from the root
+        int index = 0;
+        for (;;)
+        {
+            int child = index * 2 + 1;
+            if (child >= numEvents)
+                break;
+
+            if (child + 1 < numEvents
+                && events[static_cast<size_t>(child + 1)].*timeMember < events[static_cast<size_t>(child)].*timeMember)
+                ++child;
+
+            if (last.*timeMember <= events[static_cast<size_t>(child)].*timeMember)
+                break;
+
+            events[static_cast<size_t>(index)] = events[static_cast<size_t>(child)];
+            index = child;
+        }
+
+        if (numEvents > 0)
+            events[static_cast<size_t>(index)] = last;
+
+        return earliest;
+    }
+
+private:
+    std::array<Event, static_cast<size_t>(Capacity)> events {};
+    int numEvents = 0;
+};
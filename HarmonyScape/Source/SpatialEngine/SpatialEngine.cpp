@@ -19,48 +19,64 @@ void SpatialEngine::prepare(double newSampleRate, int newSamplesPerBlock)
 {
     sampleRate = newSampleRate;
     samplesPerBlock = newSamplesPerBlock;
+    updateEnvelopeRates();
+    volumeRamp.prepare(sampleRate, samplesPerBlock, volumeRampSeconds);
+    widthRamp.prepare(sampleRate, samplesPerBlock, widthRampSeconds);
+    
+    // Restart the random sequence so every render from here reproduces exactly
+    random.setSeed(randomSeed.load(), randomStream);
+}
+
+void SpatialEngine::setEnvelope(const ADSRParams& adsr)
+{
+    envelope = adsr;
+    updateEnvelopeRates();
+}
+
+void SpatialEngine::updateEnvelopeRates()
+{
+    const auto rate = static_cast<float>(sampleRate);
+    
+    envelopeRates.attackIncrement = envelope.attack > 0.0f ? 1.0f / (envelope.attack * rate)
+                                                           : 1.0f; // Instant attack
+    envelopeRates.decayIncrement = envelope.decay > 0.0f ? (envelope.sustain - 1.0f) / (envelope.decay * rate)
+                                                         : envelope.sustain - 1.0f; // Instant decay
+    envelopeRates.releaseScale = envelope.release > 0.001f ? 1.0f / (envelope.release * rate)
+                                                           : 1.0f; // Immediate release
 }
 
-void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiBuffer, 
+void SpatialEngine::process(juce::AudioBuffer<float>& buffer, juce::Span<const NoteEvent> noteEvents, 
                            float spatialWidth, WaveformType waveformType, float volume,
-                           const ADSRParams& adsr, const SpatialParams& spatialParams,
-                           const RhythmParams& rhythmParams)
+                           const SpatialParams& spatialParams, const RhythmParams& rhythmParams)
 {
     int numSamples = buffer.getNumSamples();
     
     // Clear the buffer first
     buffer.clear();
     
+    // New values glide in over the ramp time rather than stepping at the block edge
+    volumeRamp.setTargetValue(volume);
+    widthRamp.setTargetValue(spatialWidth);
+    
     // Get current time for note timeout checks
     int64_t currentTime = juce::Time::currentTimeMillis();
     
-    // Process all MIDI messages at the start of the buffer
+    // Process all note events at the start of the buffer
     juce::Array<int> activeNotes;
     
-    // Track which notes have been stopped in this block
-    juce::Array<int> stoppedNotes;
-    
-    // CRITICAL FIX: Clear the arrays at the start of each process block
-    userInputNotes.clearQuick();
-    generatedNotes.clearQuick();
-    
-    // First pass - collect all note-on and note-off messages
-    for (const auto metadata : midiBuffer)
+    // First pass - collect all note-on and note-off events
+    for (const auto& event : noteEvents)
     {
-        auto message = metadata.getMessage();
+        const int noteNumber = event.noteNumber;
         
-        if (message.isNoteOn() && message.getVelocity() > 0) // Ensure non-zero velocity
+        if (event.isNoteOn && event.velocity > 0.0f) // Ensure non-zero velocity
         {
-            int noteNumber = message.getNoteNumber();
             activeNotes.addIfNotAlreadyThere(noteNumber);
             
-            // CRITICAL: Track user input notes
-            userInputNotes.addIfNotAlreadyThere(noteNumber);
-            
             // CRITICAL FIX: Ensure voice is properly activated
             for (auto& voice : voices)
             {
-                if (voice.midiNote == noteNumber)
+                if (voice.midiNote == noteNumber && voice.midiChannel == event.channel)
                 {
                     voice.active = true;
                     voice.envelopeState = Voice::EnvelopeState::Attack;
@@ -69,25 +85,33 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
                 }
             }
         }
-        else if (message.isNoteOff() || (message.isNoteOn() && message.getVelocity() == 0))
+        else
         {
-            int noteNumber = message.getNoteNumber();
-            stoppedNotes.add(noteNumber);
             activeNotes.removeFirstMatchingValue(noteNumber);
-            userInputNotes.removeFirstMatchingValue(noteNumber);
         }
     }
     
     // Sort active notes to determine chord structure
     activeNotes.sort();
     
-    // Second pass - process note-on messages with chord position context
-    for (const auto metadata : midiBuffer)
+    // Second pass - process note-on events with chord position context
+    for (const auto& event : noteEvents)
     {
-        auto message = metadata.getMessage();
-        
-        if (message.isNoteOn() && message.getVelocity() > 0)
+        if (event.isNoteOn && event.velocity > 0.0f)
         {
+            const int noteNumber = event.noteNumber;
+            
+            // The engine that made the note knows its place in the chord and its pan
+            // best; notes without them are placed from the block's chord
+            const int chordPosition = event.voiceHint >= 0 ? event.voiceHint : activeNotes.indexOf(noteNumber);
+            
+            // Voices keep their full-width position; the width ramp scales it as they render
+            auto positionForNote = [&]
+            {
+                return event.hasPan ? juce::jlimit(-1.0f, 1.0f, event.pan)
+                                    : calculatePosition(noteNumber, chordPosition, 1.0f);
+            };
+            
             // Find a free voice for this note or reuse one already releasing
             bool noteAssigned = false;
             
@@ -96,11 +120,7 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
             {
                 if (voice.envelopeState == Voice::EnvelopeState::Idle)
                 {
-                    int noteNumber = message.getNoteNumber();
-                    int chordPosition = activeNotes.indexOf(noteNumber);
-                    voice.trigger(noteNumber, 
-                                 calculatePosition(noteNumber, chordPosition, spatialWidth),
-                                 chordPosition);
+                    voice.trigger(noteNumber, event.channel, positionForNote(), chordPosition, event.velocity, event.source);
                     voice.envelopeLevel = 0.0f;
                     voice.active = true;
                     voice.envelopeState = Voice::EnvelopeState::Attack;
@@ -116,11 +136,7 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
                 {
                     if (!voice.active && voice.envelopeState == Voice::EnvelopeState::Release && voice.envelopeLevel < 0.1f)
                     {
-                        int noteNumber = message.getNoteNumber();
-                        int chordPosition = activeNotes.indexOf(noteNumber);
-                        voice.trigger(noteNumber, 
-                                     calculatePosition(noteNumber, chordPosition, spatialWidth),
-                                     chordPosition);
+                        voice.trigger(noteNumber, event.channel, positionForNote(), chordPosition, event.velocity, event.source);
                         voice.envelopeLevel = 0.0f;
                         voice.active = true;
                         voice.envelopeState = Voice::EnvelopeState::Attack;
@@ -148,9 +164,6 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
                 
                 if (oldestIndex >= 0)
                 {
-                    int noteNumber = message.getNoteNumber();
-                    int chordPosition = activeNotes.indexOf(noteNumber);
-                    
                     // ANTI-POP: Gentle voice stealing with crossfade
                     auto& oldVoice = voices[static_cast<size_t>(oldestIndex)];
                     if (oldVoice.envelopeLevel > 0.01f)
@@ -159,9 +172,7 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
                         oldVoice.envelopeLevel *= 0.1f;
                     }
                     
-                    oldVoice.trigger(noteNumber, 
-                                    calculatePosition(noteNumber, chordPosition, spatialWidth),
-                                    chordPosition);
+                    oldVoice.trigger(noteNumber, event.channel, positionForNote(), chordPosition, event.velocity, event.source);
                     oldVoice.envelopeLevel = 0.0f;
                     oldVoice.active = true;
                     oldVoice.envelopeState = Voice::EnvelopeState::Attack;
@@ -171,14 +182,16 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
     }
     
     // Third pass - process note-off messages
-    for (int i = 0; i < stoppedNotes.size(); ++i)
+    for (const auto& event : noteEvents)
     {
-        int noteNumber = stoppedNotes[i];
+        if (event.isNoteOn && event.velocity > 0.0f)
+            continue;
         
-        // Release any matching voices with smooth transition
+        // Release any voices playing this note on this channel with smooth transition
         for (auto& voice : voices)
         {
-            if (voice.midiNote == noteNumber && voice.envelopeState != Voice::EnvelopeState::Idle)
+            if (voice.midiNote == event.noteNumber && voice.midiChannel == event.channel
+                && voice.envelopeState != Voice::EnvelopeState::Idle)
             {
                 voice.active = false;
                 
@@ -200,20 +213,6 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
         }
     }
     
-    // Update output notes array for keyboard display
-    if (!chordOutput.isEmpty())
-    {
-        generatedNotes.clearQuick();
-        for (const auto metadata : chordOutput)
-        {
-            auto message = metadata.getMessage();
-            if (message.isNoteOn())
-            {
-                generatedNotes.addIfNotAlreadyThere(message.getNoteNumber());
-            }
-        }
-    }
-    
     // Calculate active voice count for volume scaling
     int activeVoiceCount = 0;
     for (const auto& voice : voices)
@@ -224,36 +223,43 @@ void SpatialEngine::process(juce::AudioBuffer<float>& buffer, const juce::MidiBu
         }
     }
     
-    // Render all active voices
-    float masterVolume = volume * 0.5f; // Overall volume scaling to prevent clipping
+    // Overall volume scaling to prevent clipping, reduced further with the number
+    // of active voices
+    float voiceGain = 0.5f;
+    if (activeVoiceCount > 1)
+        voiceGain /= std::sqrt(static_cast<float>(activeVoiceCount));
     
-    for (auto& voice : voices)
+    // Render all active voices, in spans no longer than the ramp buffers
+    for (int startSample = 0; startSample < numSamples;)
     {
-        // CRITICAL FIX: Only skip rendering if voice is completely idle
-        if (voice.envelopeState != Voice::EnvelopeState::Idle)
+        const int spanSamples = juce::jmin(numSamples - startSample, volumeRamp.getMaximumBlockSize(),
+                                           widthRamp.getMaximumBlockSize());
+        
+        OutputRamps ramps;
+        ramps.volume = volumeRamp.getNextBlock(spanSamples);
+        ramps.width = widthRamp.getNextBlock(spanSamples);
+        ramps.widthRamping = widthRamp.isRamping();
+        
+        for (auto& voice : voices)
         {
-            // Apply volume scaling based on number of active voices to prevent clipping
-            float voiceVolume = masterVolume;
-            if (activeVoiceCount > 0 && activeVoiceCount > 1)
-            {
-                voiceVolume = masterVolume / std::sqrt(static_cast<float>(activeVoiceCount));
-            }
-            
-            renderVoice(voice, buffer, 0, numSamples, waveformType, voiceVolume, adsr);
+            // CRITICAL FIX: Only skip rendering if voice is completely idle
+            if (voice.envelopeState != Voice::EnvelopeState::Idle)
+                renderVoice(voice, buffer, startSample, spanSamples, waveformType, voiceGain, ramps);
         }
+        
+        startSample += spanSamples;
     }
 }
 
-void SpatialEngine::processEnvelope(Voice& voice, const ADSRParams& adsr, float& envelopeIncrement)
+void SpatialEngine::processEnvelope(Voice& voice, float& envelopeIncrement)
 {
-    // Calculate envelope increments based on current state
+    const auto& adsr = envelope;
+    
+    // Envelope increments for the current state (rates are precomputed by setEnvelope)
     switch (voice.envelopeState)
     {
         case Voice::EnvelopeState::Attack:
-            if (adsr.attack > 0.0f)
-                envelopeIncrement = 1.0f / (adsr.attack * static_cast<float>(sampleRate));
-            else
-                envelopeIncrement = 1.0f; // Instant attack
+            envelopeIncrement = envelopeRates.attackIncrement;
             
             if (voice.envelopeLevel >= 1.0f)
             {
@@ -263,10 +269,7 @@ void SpatialEngine::processEnvelope(Voice& voice, const ADSRParams& adsr, float&
             break;
             
         case Voice::EnvelopeState::Decay:
-            if (adsr.decay > 0.0f)
-                envelopeIncrement = (adsr.sustain - 1.0f) / (adsr.decay * static_cast<float>(sampleRate));
-            else
-                envelopeIncrement = adsr.sustain - 1.0f; // Instant decay
+            envelopeIncrement = envelopeRates.decayIncrement;
             
             if (voice.envelopeLevel <= adsr.sustain)
             {
@@ -287,15 +290,8 @@ void SpatialEngine::processEnvelope(Voice& voice, const ADSRParams& adsr, float&
             break;
             
         case Voice::EnvelopeState::Release:
-            if (adsr.release > 0.001f)
-            {
-                // Calculate release rate to reach 0 from current level
-                envelopeIncrement = -voice.envelopeLevel / (adsr.release * static_cast<float>(sampleRate));
-            }
-            else
-            {
-                envelopeIncrement = -voice.envelopeLevel; // Immediate release
-            }
+            // Release rate to reach 0 from the current level
+            envelopeIncrement = -voice.envelopeLevel * envelopeRates.releaseScale;
             
             // ANTI-POP: Ensure we don't go below zero and transition smoothly to idle
             if (voice.envelopeLevel <= 0.001f)
@@ -324,8 +320,7 @@ void SpatialEngine::processEnvelope(Voice& voice, const ADSRParams& adsr, float&
 
 void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, 
                                int startSample, int numSamples, 
-                               WaveformType waveformType, float masterVolume,
-                               const ADSRParams& adsr)
+                               WaveformType waveformType, float voiceGain, const OutputRamps& ramps)
 {
     // Check we have stereo output
     if (buffer.getNumChannels() < 2)
@@ -342,9 +337,10 @@ void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer,
     float lfoPhase = std::fmod(voice.noteStartTime * 0.001f + voice.chordPosition * 0.3f, 1.0f);
     float pitchModAmount = 0.002f + (voice.chordPosition * 0.001f);
     
-    // Calculate stereo position (pan)
-    float leftGain = std::sqrt(0.5f - voice.position * 0.5f);
-    float rightGain = std::sqrt(0.5f + voice.position * 0.5f);
+    // Calculate stereo position (pan); only recomputed per sample while the width glides
+    float pan = voice.position * ramps.width[0];
+    float leftGain = std::sqrt(0.5f - pan * 0.5f);
+    float rightGain = std::sqrt(0.5f + pan * 0.5f);
     
     // Dynamic filter cutoff based on envelope and note pitch
     float baseCutoff = 0.4f + (voice.midiNote / 127.0f) * 0.4f;
@@ -363,7 +359,7 @@ void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer,
     {
         // Process envelope for this sample
         float envelopeIncrement = 0.0f;
-        processEnvelope(voice, adsr, envelopeIncrement);
+        processEnvelope(voice, envelopeIncrement);
         
         // Apply envelope increment
         voice.envelopeLevel += envelopeIncrement;
@@ -393,6 +389,8 @@ void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer,
         
         // Generate sample based on waveform type
         float sample = generateSample(voice.phase, waveformType);
+        if (waveformBlend > 0.0f && blendWaveform != waveformType)
+            sample += (generateSample(voice.phase, blendWaveform) - sample) * waveformBlend;
         
         // ANTI-CLICK: Simple ramp for the first few samples of any note
         float clickPreventionGain = 1.0f;
@@ -415,7 +413,8 @@ void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer,
         }
         
         // Apply envelope and click prevention
-        sample = sample * voice.smoothedEnvelopeLevel * masterVolume * clickPreventionGain;
+        sample = sample * voice.smoothedEnvelopeLevel * voice.velocity * (ramps.volume[i] * voiceGain)
+                 * clickPreventionGain;
         
         // Dynamic filter that opens with envelope (low-pass)
         float dynamicCutoff = baseCutoff + (voice.envelopeLevel * 0.2f);
@@ -435,6 +434,13 @@ void SpatialEngine::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer,
         filteredSample = std::tanh(filteredSample * 0.7f) * 0.9f;
         
         // Write to stereo output with panning
+        if (ramps.widthRamping)
+        {
+            pan = voice.position * ramps.width[i];
+            leftGain = std::sqrt(0.5f - pan * 0.5f);
+            rightGain = std::sqrt(0.5f + pan * 0.5f);
+        }
+        
         leftBuffer[i] += filteredSample * leftGain;
         rightBuffer[i] += filteredSample * rightGain;
         
@@ -466,8 +472,8 @@ float SpatialEngine::calculatePosition(int midiNote, int chordPosition, float wi
     else // Odd positions including thirds, sevenths
         positionFactor = 0.8f;
     
-    // Slight randomization based on MIDI note number
-    float jitter = (midiNote % 5) / 20.0f - 0.1f; // -0.1 to 0.1
+    // Slight randomization from the engine's seeded generator
+    float jitter = random.nextBipolar() * 0.1f; // -0.1 to 0.1
     
     // Combine factors with balanced weights
     float position = (noteHeight * 0.3f) + (positionFactor * 0.6f) + jitter;
@@ -588,11 +594,22 @@ float SpatialEngine::applyRhythmicTiming(float baseTime, const RhythmParams& rhy
     return modifiedTime;
 }
 
-juce::Array<int> SpatialEngine::getActiveVoiceNotes() const
+int SpatialEngine::getVoiceTelemetry(juce::Span<VoiceTelemetry> dest) const
 {
-    // Return a combination of user input notes and generated notes
-    juce::Array<int> allNotes;
-    allNotes.addArray(userInputNotes);
-    allNotes.addArray(generatedNotes);
-    return allNotes;
+    const float width = widthRamp.getCurrentValue();
+    int numVoices = 0;
+    
+    for (const auto& voice : voices)
+    {
+        if (voice.envelopeState == Voice::EnvelopeState::Idle || numVoices == static_cast<int>(dest.size()))
+            continue;
+        
+        auto& state = dest[static_cast<size_t>(numVoices++)];
+        state.midiNote = voice.midiNote;
+        state.pan = voice.position * width;
+        state.level = voice.smoothedEnvelopeLevel * voice.velocity;
+        state.source = voice.source;
+    }
+    
+    return numVoices;
 } 
@@ -2,7 +2,11 @@
 
 #include "../JuceHeader.h"
 #include "../Voice.h"
+#include "../NoteEvent.h"
+#include "../RealtimeRandom.h"
+#include "../ParameterRamp.h"
 #include <array>
+#include <atomic>
 
 // Forward declarations
 struct Voice;
@@ -61,55 +65,75 @@ public:
      */
     void prepare(double sampleRate, int samplesPerBlock);
     
+    /**
+     * Seed for pan jitter and any other randomised behaviour.
+     * Takes effect on the next prepare().
+     */
+    void setRandomSeed(uint64_t seed) { randomSeed.store(seed); }
+    
+    /**
+     * Sets the ADSR envelope and recomputes its per-sample rates. Only needs calling
+     * when the envelope parameters change; prepare() keeps the rates in step with
+     * the sample rate.
+     */
+    void setEnvelope(const ADSRParams& adsr);
+    
+    /**
+     * Layers a second waveform under the one passed to process(), so a morph can
+     * crossfade between waveforms instead of switching.
+     * @param amount Share of the other waveform (0 = off, 1 = only the other one)
+     */
+    void setWaveformBlend(WaveformType other, float amount)
+    {
+        blendWaveform = other;
+        waveformBlend = juce::jlimit(0.0f, 1.0f, amount);
+    }
+    
     /**
      * Process audio buffer using generated chord voicings
      * @param buffer Audio buffer to fill with generated sounds
-     * @param midiBuffer MIDI data representing chord voicings
-     * @param spatialWidth Width parameter (0.0-1.0) controlling stereo spread
+     * @param noteEvents The block's notes from every layer, in sample order. A pan or
+     *                   voice hint set by the originating engine is used as given.
+     * @param spatialWidth Width parameter (0.0-1.0) controlling stereo spread; a change
+     *                     glides in over widthRampSeconds, sounding voices included
      * @param waveformType The type of waveform to generate
-     * @param volume Master volume level (0.0-1.0)
-     * @param adsr ADSR envelope parameters
+     * @param volume Master volume level (0.0-1.0); a change glides in over volumeRampSeconds
      * @param spatialParams Spatial movement parameters
      * @param rhythmParams Rhythmic parameters
      */
-    void process(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiBuffer, 
+    void process(juce::AudioBuffer<float>& buffer, juce::Span<const NoteEvent> noteEvents, 
                 float spatialWidth, WaveformType waveformType, float volume,
-                const ADSRParams& adsr, const SpatialParams& spatialParams,
-                const RhythmParams& rhythmParams);
+                const SpatialParams& spatialParams, const RhythmParams& rhythmParams);
     
     // Backward compatible overload without new parameters
-    void process(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiBuffer, 
-                float spatialWidth, WaveformType waveformType, float volume,
-                const ADSRParams& adsr)
+    void process(juce::AudioBuffer<float>& buffer, juce::Span<const NoteEvent> noteEvents, 
+                float spatialWidth, WaveformType waveformType, float volume)
     {
         // Use default values for new parameters
         SpatialParams defaultSpatial;
         RhythmParams defaultRhythm;
-        process(buffer, midiBuffer, spatialWidth, waveformType, volume, adsr, 
+        process(buffer, noteEvents, spatialWidth, waveformType, volume,
                 defaultSpatial, defaultRhythm);
     }
                 
-    /**
-     * Get all currently active voice notes (including those in release phase)
-     * Used for visual display of active notes
-     * @return Array of MIDI note numbers that are currently sounding
-     */
-    juce::Array<int> getActiveVoiceNotes() const;
+    // Polyphony
+    static constexpr int MAX_VOICES = 16;
     
-    /**
-     * Get user input notes for keyboard visualization
-     * @return Array of MIDI note numbers played by the user
-     */
-    juce::Array<int> getUserInputNotes() const { return userInputNotes; }
+    // Display state of one audible voice
+    struct VoiceTelemetry
+    {
+        int midiNote = 0;
+        float pan = 0.0f;       // -1.0 to 1.0, current width applied
+        float level = 0.0f;     // Envelope level times velocity
+        NoteEvent::Source source = NoteEvent::Source::Input;    // Layer that started the voice
+    };
     
     /**
-     * Get generated harmony notes for keyboard visualization
-     * @return Array of MIDI note numbers generated by the chord engine
+     * Audio thread: the state of every voice still audible (releases included),
+     * for display. Doesn't allocate.
+     * @return Number of voices written to dest
      */
-    juce::Array<int> getGeneratedNotes() const { return generatedNotes; }
-    
-    // Store generated chord output for visualization
-    void setChordOutput(const juce::MidiBuffer& output) { chordOutput = output; }
+    int getVoiceTelemetry(juce::Span<VoiceTelemetry> dest) const;
     
 private:
     /**
@@ -118,10 +142,13 @@ private:
     struct Voice
     {
         int midiNote = 0;
+        int midiChannel = 1;    // Channel of the note, so releases match (channel, note)
         bool active = false;
         float position = 0.0f;  // -1.0 to 1.0 (stereo position)
+        float velocity = 1.0f;  // Gain from the note's velocity
         float phase = 0.0f;
         int chordPosition = 0;  // Position within the chord (0 = root, etc.)
+        NoteEvent::Source source = NoteEvent::Source::Input;    // Layer the note came from
         
         // Time tracking for safety release
         int64_t noteStartTime = 0;
@@ -144,12 +171,16 @@ private:
         float highpassState = 0.0f;  // High-pass filter state for removing muddiness
         int sampleCounter = 0;       // Count samples since note start for anti-click
         
-        void trigger(int note, float pos, int chordPos = 0) 
+        void trigger(int note, int channel, float pos, int chordPos = 0, float vel = 1.0f,
+                     NoteEvent::Source noteSource = NoteEvent::Source::Input) 
         {
             midiNote = note;
+            midiChannel = channel;
             active = true;
             position = pos;
+            velocity = vel;
             chordPosition = chordPos;
+            source = noteSource;
             envelopeState = EnvelopeState::Attack;
             noteStartTime = juce::Time::currentTimeMillis();
             
@@ -203,16 +234,31 @@ private:
         }
     };
     
+    // Per-sample output parameters for one render span
+    struct OutputRamps
+    {
+        const float* volume = nullptr;  // Master volume for each sample
+        const float* width = nullptr;   // Stereo width for each sample
+        bool widthRamping = false;      // False if every width value is the same
+    };
+    
     /**
      * Renders a single voice to the buffer
+     * @param voiceGain Gain applied on top of the volume ramp (voice count scaling)
+     * @param ramps Volume and width for the rendered samples, indexed from startSample
      */
     void renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, int startSample, int numSamples, 
-                    WaveformType waveformType, float masterVolume, const ADSRParams& adsr);
+                    WaveformType waveformType, float voiceGain, const OutputRamps& ramps);
     
     /**
      * Processes the envelope for a voice
      */
-    void processEnvelope(Voice& voice, const ADSRParams& adsr, float& envelopeIncrement);
+    void processEnvelope(Voice& voice, float& envelopeIncrement);
+    
+    /**
+     * Recomputes the envelope rates from envelope and sampleRate
+     */
+    void updateEnvelopeRates();
     
     /**
      * Calculates stereo position for a given MIDI note and chord position
@@ -240,16 +286,31 @@ private:
     float applyRhythmicTiming(float baseTime, const RhythmParams& rhythmParams);
     
     // Audio generator state
-    std::array<Voice, 16> voices;  // Polyphony of 16 voices
+    std::array<Voice, MAX_VOICES> voices;
     
     // Cached parameters
     double sampleRate = 44100.0;
     int samplesPerBlock = 512;
     
-    // Track active notes for keyboard visualization
-    juce::Array<int> userInputNotes;
-    juce::Array<int> generatedNotes;
-    juce::MidiBuffer chordOutput;  // Store the last chord output for visualization
+    // Envelope and the per-sample rates derived from it
+    ADSRParams envelope { 0.01f, 0.1f, 0.5f, 0.2f };
+    struct EnvelopeRates
+    {
+        float attackIncrement = 1.0f;    // Per sample, towards 1
+        float decayIncrement = 0.0f;     // Per sample, towards sustain (negative)
+        float releaseScale = 1.0f;       // Fraction of the level released per sample
+    };
+    EnvelopeRates envelopeRates;
+    
+    // Second waveform layer set by setWaveformBlend
+    WaveformType blendWaveform = WaveformType::Sine;
+    float waveformBlend = 0.0f;
+    
+    // Volume and width glide between block values instead of stepping
+    static constexpr double volumeRampSeconds = 0.02;
+    static constexpr double widthRampSeconds = 0.05;
+    ParameterRamp<> volumeRamp;
+    ParameterRamp<> widthRamp;
 
     // LFO state for spatial movement
     struct LFOState
@@ -267,4 +328,9 @@ private:
     // Time tracking for movement
     double currentTime = 0.0;
     double lastProcessTime = 0.0;
+    
+    // Deterministic randomness (pan jitter)
+    static constexpr uint32_t randomStream = 2;
+    std::atomic<uint64_t> randomSeed { RealtimeRandom::defaultSeed };
+    RealtimeRandom random;
 }; 
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "StateSerializer.h"
+#include "CompactCodec.h"
+#include "RealtimeRandom.h"
+#include <array>
+#include <cstring>
+
+StateSerializer::StateSerializer(juce::AudioProcessorValueTreeState& parametersToSave)
+    : parameters(parametersToSave)
+{
+    for (auto* parameter : parameters.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parameterList.push_back(ranged);
+
+    jassert(parameterList.size() <= static_cast<size_t>(maxParameters));
+
+    // FNV-1a over the parameter IDs in order, kept for every prefix of the list
+    uint32_t hash = 2166136261u;
+    for (const auto* parameter : parameterList)
+    {
+        for (auto c : parameter->getParameterID())
+            hash = (hash ^ static_cast<uint32_t>(c)) * 16777619u;
+
+        hash *= 16777619u;      // Separator, so "ab" + "c" differs from "a" + "bc"
+        layoutHashes.push_back(hash);
+    }
+}
+
+void StateSerializer::save(juce::MemoryBlock& destData) const
+{
+    const int numValues = static_cast<int>(juce::jmin(parameterList.size(), static_cast<size_t>(maxParameters)));
+
+    std::array<uint8_t, maxPayloadSize> payload;
+    write32(payload.data(), getLayoutHash());
+    write32(payload.data() + 4, static_cast<uint32_t>(numValues));
+
+    const auto seed = static_cast<juce::int64>(parameters.state.getProperty(
+        "randomSeed", static_cast<juce::int64>(RealtimeRandom::defaultSeed)));
+    write64(payload.data() + 8, static_cast<uint64_t>(seed));
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        const auto* parameter = parameterList[static_cast<size_t>(i)];
+        const float value = parameter->convertFrom0to1(parameter->getValue());
+
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write32(payload.data() + 16 + i * 4, bits);
+    }
+
+    const int payloadSize = 16 + numValues * 4;
+
+    // Compressed only when it actually saves space
+    std::array<uint8_t, CompactCodec::getMaxCompressedSize(maxPayloadSize)> compressed;
+    const int compressedSize = CompactCodec::compress(payload.data(), payloadSize,
+                                                      compressed.data(), static_cast<int>(compressed.size()));
+    const bool useCompression = compressedSize > 0 && compressedSize < payloadSize;
+    const int storedSize = useCompression ? compressedSize : payloadSize;
+
+    destData.setSize(static_cast<size_t>(headerSize + storedSize));
+    auto* dest = static_cast<uint8_t*>(destData.getData());
+
+    write32(dest, magic);
+    write16(dest + 4, currentVersion);
+    write16(dest + 6, useCompression ? compressedPayload : 0);
+    write32(dest + 8, static_cast<uint32_t>(payloadSize));
+    write32(dest + 12, static_cast<uint32_t>(storedSize));
+    std::memcpy(dest + headerSize, useCompression ? compressed.data() : payload.data(), static_cast<size_t>(storedSize));
+}
+
+bool StateSerializer::load(const void* data, int sizeInBytes)
+{
+    if (isBinaryState(data, sizeInBytes))
+        return loadBinary(static_cast<const uint8_t*>(data), sizeInBytes);
+
+    return loadLegacyXml(data, sizeInBytes);
+}
+
+bool StateSerializer::isBinaryState(const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= headerSize && read32(static_cast<const uint8_t*>(data)) == magic;
+}
+
+bool StateSerializer::loadBinary(const uint8_t* data, int sizeInBytes)
+{
+    const auto version = read16(data + 4);
+    const auto flags = read16(data + 6);
+    const auto payloadSize = static_cast<int>(read32(data + 8));
+    const auto storedSize = static_cast<int>(read32(data + 12));
+
+    // Newer formats and unknown flags can't be read safely
+    if (version == 0 || version > currentVersion || (flags & ~compressedPayload) != 0)
+        return false;
+
+    if (payloadSize < 16 || payloadSize > maxPayloadSize || storedSize < 0 || storedSize > sizeInBytes - headerSize)
+        return false;
+
+    std::array<uint8_t, maxPayloadSize> payload;
+    if ((flags & compressedPayload) != 0)
+    {
+        if (!CompactCodec::decompress(data + headerSize, storedSize, payload.data(), payloadSize))
+            return false;
+    }
+    else
+    {
+        if (storedSize != payloadSize)
+            return false;
+
+        std::memcpy(payload.data(), data + headerSize, static_cast<size_t>(payloadSize));
+    }
+
+    // A state saved before parameters were appended matches a prefix of the list
+    const auto numValues = static_cast<int>(read32(payload.data() + 4));
+    if (numValues < 1 || numValues > static_cast<int>(parameterList.size())
+        || read32(payload.data()) != layoutHashes[static_cast<size_t>(numValues - 1)]
+        || payloadSize != 16 + numValues * 4)
+    {
+        // Saved with a different parameter list: needs a migration for its version
+        jassertfalse;
+        return false;
+    }
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        const uint32_t bits = read32(payload.data() + 16 + i * 4);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+
+        auto* parameter = parameterList[static_cast<size_t>(i)];
+        const auto& range = parameter->getNormalisableRange();
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(juce::jlimit(range.start, range.end, value)));
+    }
+
+    // Parameters added since the state was saved start from their defaults
+    for (size_t i = static_cast<size_t>(numValues); i < parameterList.size(); ++i)
+        parameterList[i]->setValueNotifyingHost(parameterList[i]->getDefaultValue());
+
+    parameters.state.setProperty("randomSeed", static_cast<juce::int64>(read64(payload.data() + 8)), nullptr);
+    return true;
+}
+
+bool StateSerializer::loadLegacyXml(const void* data, int sizeInBytes)
+{
+    std::unique_ptr<juce::XmlElement> xmlState (juce::AudioProcessor::getXmlFromBinary (data, sizeInBytes));
+
+    if (xmlState == nullptr || !xmlState->hasTagName (parameters.state.getType()))
+        return false;
+
+    parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+    return true;
+}
+
+void StateSerializer::write16(uint8_t* dest, uint16_t value) noexcept
+{
+    dest[0] = static_cast<uint8_t>(value);
+    dest[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void StateSerializer::write32(uint8_t* dest, uint32_t value) noexcept
+{
+    write16(dest, static_cast<uint16_t>(value));
+    write16(dest + 2, static_cast<uint16_t>(value >> 16));
+}
+
+void StateSerializer::write64(uint8_t* dest, uint64_t value) noexcept
+{
+    write32(dest, static_cast<uint32_t>(value));
+    write32(dest + 4, static_cast<uint32_t>(value >> 32));
+}
+
+uint16_t StateSerializer::read16(const uint8_t* source) noexcept
+{
+    return static_cast<uint16_t>(source[0] | (source[1] << 8));
+}
+
+uint32_t StateSerializer::read32(const uint8_t* source) noexcept
+{
+    return read16(source) | (static_cast<uint32_t>(read16(source + 2)) << 16);
+}
+
+uint64_t StateSerializer::read64(const uint8_t* source) noexcept
+{
+    return read32(source) | (static_cast<uint64_t>(read32(source + 4)) << 32);
+}
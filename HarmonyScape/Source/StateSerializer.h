@@ -0,0 +1,74 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <vector>
+
+/**
+ * Saves and restores the plugin state in a compact, versioned binary format.
+ *
+ * Layout (all fields little-endian):
+ *   header   magic "HSst", uint16 format version, uint16 flags,
+ *            uint32 payload size, uint32 stored (possibly compressed) size
+ *   payload  uint32 parameter layout hash, uint32 value count, int64 random seed,
+ *            float plain value of every parameter in processor order
+ *
+ * The payload is stored CompactCodec-compressed when that makes it smaller.
+ * Saving reads the parameters directly and loading sets them directly, so
+ * neither touches the value tree's XML.
+ *
+ * States saved as XML by earlier versions are still loaded (through the value
+ * tree, as before) and are written back in the binary format on the next save.
+ *
+ * The value block is fixed-layout: its hash covers every parameter ID in order.
+ * Parameters appended to the list migrate by themselves: an older state's hash
+ * matches the hash of the list's first value-count parameters, and the newer
+ * parameters take their defaults. Any other change to the parameter list must
+ * bump currentVersion and add a migration for older versions.
+ */
+class StateSerializer
+{
+public:
+    static constexpr uint32_t magic = 0x74735348;     // "HSst"
+    static constexpr uint16_t currentVersion = 1;
+
+    enum Flags : uint16_t
+    {
+        compressedPayload = 1 << 0
+    };
+
+    explicit StateSerializer(juce::AudioProcessorValueTreeState& parameters);
+
+    /** Writes the current parameter values and seed */
+    void save(juce::MemoryBlock& destData) const;
+
+    /**
+     * Restores a binary state or migrates an XML state from an earlier version.
+     * @return False if the data is neither, or can't be read; the state is unchanged then
+     */
+    bool load(const void* data, int sizeInBytes);
+
+    static bool isBinaryState(const void* data, int sizeInBytes) noexcept;
+
+    uint32_t getLayoutHash() const noexcept { return layoutHashes.empty() ? 0 : layoutHashes.back(); }
+
+private:
+    static constexpr int headerSize = 16;
+    static constexpr int maxParameters = 64;
+    static constexpr int maxPayloadSize = 16 + maxParameters * 4;
+
+    bool loadBinary(const uint8_t* data, int sizeInBytes);
+    bool loadLegacyXml(const void* data, int sizeInBytes);
+
+    static void write16(uint8_t* dest, uint16_t value) noexcept;
+    static void write32(uint8_t* dest, uint32_t value) noexcept;
+    static void write64(uint8_t* dest, uint64_t value) noexcept;
+    static uint16_t read16(const uint8_t* source) noexcept;
+    static uint32_t read32(const uint8_t* source) noexcept;
+    static uint64_t read64(const uint8_t* source) noexcept;
+
+    juce::AudioProcessorValueTreeState& parameters;
+    std::vector<juce::RangedAudioParameter*> parameterList;
+    std::vector<uint32_t> layoutHashes;     // Hash of the first n + 1 parameter IDs
+
+    JUCE_DECLARE_NON_COPYABLE (StateSerializer)
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+ * Wait-free single-producer / single-consumer snapshot exchange.
+ *
+ * The writer fills getWriteBuffer() and calls publish(); the reader calls read()
+ * and always gets the most recently published complete snapshot. Neither side
+ * ever blocks or waits for the other: the three slots are handed over by
+ * swapping a shared index, so the writer can publish as often as it likes and
+ * the reader simply skips stale snapshots.
+ *
+ * The write buffer is not cleared between publishes; it holds whatever snapshot
+ * was last swapped back to the writer, so writers should fill it completely.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    /** Writer thread: the slot to fill before the next publish(). */
+    T& getWriteBuffer() noexcept { return buffers[static_cast<size_t>(writeIndex)]; }
+
+    /** Writer thread: hands the write buffer to the reader. */
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Reader thread: the latest published snapshot (the initial value until the first publish). */
+    const T& read() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) != 0)
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+
+        return buffers[static_cast<size_t>(readIndex)];
+    }
+
+private:
+    static constexpr int freshBit = 4;
+    static constexpr int indexMask = 3;
+
+    std::array<T, 3> buffers {};
+    int writeIndex = 0;                 // Owned by the writer
+    int readIndex = 1;                  // Owned by the reader
+    std::atomic<int> middle { 2 };      // Slot in transit, plus freshBit when unread
+};